@@ -0,0 +1,342 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * Benchmark suite of the nuts-getopts parser.
+ *
+ * Generates synthetic option trees and command lines and measures the time
+ * each parser entry point needs to process them.
+ *
+ * Usage: nuts-getopts-bench [-n<options>] [-a<args>] [-t<msec>]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nuts-getopts.h>
+
+// Number of options per nesting level of a deep tree.
+#define OPTIONS_PER_LEVEL 8
+
+// Short names assigned to the first options of a tree.
+static const char short_names[] =
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+enum layout { layout_flat, layout_deep };
+
+// Size of the value of a long_value argument.
+#define LONG_VALUE_SIZE 2048
+
+enum mix { mix_short, mix_long, mix_positional, mix_unknown, mix_mixed, mix_long_value };
+
+static const char* layout_names[] = { "flat", "deep" };
+
+static const char* mix_names[] = { "short", "long", "positional", "unknown", "mixed", "long_value" };
+
+struct tree {
+  int count;
+  struct nuts_getopts_option* options;
+  struct nuts_getopts_option_group* groups;
+  char* names;
+};
+
+struct cmdline {
+  int argc;
+  char** argv;
+  char* buf;
+};
+
+struct bench {
+  const struct tree* tree;
+  const struct cmdline* cmdline;
+  nuts_getopts_spec* spec;
+  struct nuts_getopts_event* events;
+  int flags;
+};
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int short_count(int count) {
+  int n = sizeof(short_names) - 1;
+  return (count < n) ? count : n;
+}
+
+/*
+ * Creates count options. Options with an even index require an argument.
+ *
+ * flat: a single group with a single option array.
+ * deep: a chain of groups, each level references OPTIONS_PER_LEVEL options
+ *       and the next level.
+ */
+static void mk_tree(struct tree* tree, int count, enum layout layout) {
+  int levels = (count + OPTIONS_PER_LEVEL - 1) / OPTIONS_PER_LEVEL;
+  int i;
+
+  tree->count = count;
+  tree->names = malloc(count * 16);
+  tree->options = calloc(count + levels, sizeof(struct nuts_getopts_option));
+  tree->groups = calloc(2 * (levels + 1), sizeof(struct nuts_getopts_option_group));
+
+  for (i = 0; i < count; i++) {
+    // In a deep tree each level is terminated by an empty option.
+    int idx = (layout == layout_deep) ? i + i / OPTIONS_PER_LEVEL : i;
+    struct nuts_getopts_option* option = &tree->options[idx];
+    char* name = tree->names + i * 16;
+
+    snprintf(name, 16, "opt-%d", i);
+
+    option->sname = (i < short_count(count)) ? short_names[i] : 0;
+    option->lname = name;
+    option->arg = (i % 2 == 0) ? nuts_getopts_required_argument : nuts_getopts_no_argument;
+  }
+
+  if (layout == layout_flat) {
+    tree->groups[0].list = tree->options;
+  } else {
+    // Level n is located at groups[2 * n] and terminated by groups[2 * n + 1].
+    for (i = 0; i < levels; i++) {
+      tree->groups[2 * i].list = tree->options + i * (OPTIONS_PER_LEVEL + 1);
+      tree->groups[2 * i].group = (i + 1 < levels) ? &tree->groups[2 * (i + 1)] : NULL;
+    }
+  }
+}
+
+static void free_tree(struct tree* tree) {
+  free(tree->names);
+  free(tree->options);
+  free(tree->groups);
+}
+
+static int mk_arg(char* buf, int count, enum mix mix, int i) {
+  int n = rand() % count;
+
+  if (mix == mix_mixed)
+    mix = i % 4;
+
+  switch (mix) {
+    case mix_short:
+      n = rand() % short_count(count);
+      return sprintf(buf, (n % 2 == 0) ? "-%c1" : "-%c", short_names[n]);
+    case mix_long:
+      return sprintf(buf, (n % 2 == 0) ? "--opt-%d=value" : "--opt-%d", n);
+    case mix_positional:
+      return sprintf(buf, "file-%d.c", n);
+    case mix_long_value: {
+      int len = sprintf(buf, "--opt-%d=", n - n % 2);
+
+      memset(buf + len, 'x', LONG_VALUE_SIZE);
+      buf[len + LONG_VALUE_SIZE] = '\0';
+
+      return len + LONG_VALUE_SIZE;
+    }
+    default:
+      // Not i, which is always odd for the unknown arguments of mix_mixed.
+      if (n % 2 == 0)
+        return sprintf(buf, "--unknown-%d=value", n);
+      else
+        return sprintf(buf, "-%c", '0' + n % 10);
+  }
+}
+
+static void mk_cmdline(struct cmdline* cmdline, int argc, int count, enum mix mix) {
+  char* p;
+  int i;
+
+  cmdline->argc = argc;
+  cmdline->argv = calloc(argc + 1, sizeof(char*));
+  cmdline->buf = p = malloc(argc * ((mix == mix_long_value) ? LONG_VALUE_SIZE + 32 : 32));
+
+  cmdline->argv[0] = strcpy(p, "/usr/bin/bench");
+  p += strlen(p) + 1;
+
+  for (i = 1; i < argc; i++) {
+    cmdline->argv[i] = p;
+    p += mk_arg(p, count, mix, i) + 1;
+  }
+}
+
+static void free_cmdline(struct cmdline* cmdline) {
+  free(cmdline->argv);
+  free(cmdline->buf);
+}
+
+static int run_getopts(const struct bench* b) {
+  const struct cmdline* c = b->cmdline;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  int n = 0;
+
+  while (nuts_getopts(c->argc, c->argv, b->tree->options, b->flags, &state, &ev) == 0)
+    n++;
+
+  return n;
+}
+
+static int run_group(const struct bench* b) {
+  const struct cmdline* c = b->cmdline;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  int n = 0;
+
+  while (nuts_getopts_group(c->argc, c->argv, b->tree->groups, b->flags, &state, &ev) == 0)
+    n++;
+
+  return n;
+}
+
+static int run_spec(const struct bench* b) {
+  const struct cmdline* c = b->cmdline;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  int n = 0;
+
+  while (nuts_getopts_spec_parse(c->argc, c->argv, b->spec, b->flags, &state, &ev) == 0)
+    n++;
+
+  return n;
+}
+
+static int run_parse_all(const struct bench* b) {
+  const struct cmdline* c = b->cmdline;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event events[256];
+  int count, n = 0;
+
+  while (nuts_getopts_parse_all(c->argc, c->argv, b->spec, b->flags, &state, events, 256, &count) == 0)
+    n += count;
+
+  return n + count;
+}
+
+static int run_parallel(const struct bench* b) {
+  const struct cmdline* c = b->cmdline;
+
+  return nuts_getopts_parse_parallel(c->argc, c->argv, b->spec, b->flags, 0, b->events);
+}
+
+static void measure(const char* name, int (*run)(const struct bench*), const struct bench* b, enum layout layout, enum mix mix, double min_ns) {
+  double start = now(), elapsed;
+  long events = 0, runs = 0;
+
+  do {
+    events += run(b);
+    runs++;
+  } while ((elapsed = now() - start) < min_ns);
+
+  printf("%-12s %-5s %7d %-11s %12.2f ",
+    name, layout_names[layout], b->tree->count, mix_names[mix],
+    elapsed / (runs * b->cmdline->argc));
+
+  // Ignored unknown options produce no events, the rate says nothing.
+  if (mix == mix_unknown)
+    printf("%14s\n", "-");
+  else
+    printf("%14.0f\n", events / (elapsed / 1e9));
+}
+
+int main(int argc, char* argv[]) {
+  const struct nuts_getopts_option options[] = {
+    { 'n', "options", nuts_getopts_required_argument },
+    { 'a', "args",    nuts_getopts_required_argument },
+    { 't', "time",    nuts_getopts_required_argument },
+    { 0 }
+  };
+  const int sizes[] = { 10, 100, 1000, 10000 };
+  int only_size = 0, nargs = 4096, msec = 100;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  unsigned int s;
+
+  while (nuts_getopts(argc, argv, options, 0, &state, &ev) == 0) {
+    if (ev.type == nuts_getopts_option_event) {
+      int value = atoi(ev.u.opt.value);
+
+      switch (ev.u.opt.option->sname) {
+        case 'n': only_size = value; break;
+        case 'a': nargs = value; break;
+        case 't': msec = value; break;
+      }
+    } else if (ev.type == nuts_getopts_error_event) {
+      fprintf(stderr, "usage: %s [-n<options>] [-a<args>] [-t<msec>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  printf("%-12s %-5s %7s %-11s %12s %14s\n",
+    "parser", "tree", "options", "argv", "ns/arg", "events/s");
+
+  for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    int count = (only_size > 0) ? only_size : sizes[s];
+    enum layout layout;
+
+    for (layout = layout_flat; layout <= layout_deep; layout++) {
+      struct tree tree;
+      enum mix mix;
+
+      mk_tree(&tree, count, layout);
+
+      for (mix = mix_short; mix <= mix_long_value; mix++) {
+        struct cmdline cmdline;
+        struct bench b = {
+          .tree = &tree,
+          .cmdline = &cmdline,
+          .spec = nuts_getopts_compile(tree.groups),
+          .events = calloc(nargs, sizeof(struct nuts_getopts_event)),
+          .flags = (mix == mix_unknown || mix == mix_mixed) ? nuts_getopts_ignore_unknown_options : 0
+        };
+
+        srand(count);
+        mk_cmdline(&cmdline, nargs, count, mix);
+
+        if (layout == layout_flat)
+          measure("getopts", run_getopts, &b, layout, mix, msec * 1e6);
+        measure("group", run_group, &b, layout, mix, msec * 1e6);
+        measure("spec", run_spec, &b, layout, mix, msec * 1e6);
+        measure("parse_all", run_parse_all, &b, layout, mix, msec * 1e6);
+        measure("parallel", run_parallel, &b, layout, mix, msec * 1e6);
+
+        nuts_getopts_spec_free(b.spec);
+        free(b.events);
+        free_cmdline(&cmdline);
+      }
+
+      free_tree(&tree);
+    }
+
+    if (only_size > 0)
+      break;
+  }
+
+  return 0;
+}
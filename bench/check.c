@@ -0,0 +1,672 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * Table driven checks of the value conversions, nuts_getopts_split(), the
+ * streams, nested response files, abbreviations and commands.
+ *
+ * Each case lists the input and the expected result. The events of a parser
+ * run are rendered into a single line, e.g. "tool --verbose file !invalid:--x",
+ * and compared as a string. Mismatches are printed, the program exits with 1
+ * if there is any.
+ *
+ * Usage: nuts-getopts-check
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <nuts-getopts.h>
+
+// Expected result of a successful conversion.
+#define OK -1
+
+#define MAX_LINE 1024
+#define MAX_ARGS 32
+
+static const char* error_names[] = {
+  "invalid", "missing", "needless", "response", "too-long", "ambiguous",
+  "value", "range", "command", "memory"
+};
+
+static const struct nuts_getopts_option value_options[] = {
+  { 'i', "int",  nuts_getopts_required_argument, nuts_getopts_int64_value },
+  { 'u', "uint", nuts_getopts_required_argument, nuts_getopts_uint64_value },
+  { 'd', "dbl",  nuts_getopts_required_argument, nuts_getopts_double_value },
+  { 'b', "bool", nuts_getopts_required_argument, nuts_getopts_bool_value },
+  { 's', "size", nuts_getopts_required_argument, nuts_getopts_size_value },
+  { 't', "time", nuts_getopts_required_argument, nuts_getopts_duration_value },
+  { 0 }
+};
+
+static const struct nuts_getopts_option tool_options[] = {
+  { 'v', "verbose", nuts_getopts_no_argument },
+  { 'n', "name",    nuts_getopts_required_argument },
+  { 0 }
+};
+
+static const struct nuts_getopts_option_group tool_groups[] = {
+  { .list = tool_options },
+  { 0 }
+};
+
+static long failures;
+
+static void check(const char* what, const char* input, const char* got, const char* expected) {
+  if (strcmp(got, expected) != 0) {
+    fprintf(stderr, "%s: %s\n  got:      %s\n  expected: %s\n", what, input, got, expected);
+    failures++;
+  }
+}
+
+// Appends the rendering of ev to line.
+static void render(char* line, const struct nuts_getopts_event* ev) {
+  size_t n = strlen(line);
+  char* p = line + n;
+  size_t size = MAX_LINE - n;
+
+  if (n > 0) {
+    *p++ = ' ';
+    size--;
+  }
+
+  switch (ev->type) {
+    case nuts_getopts_tool_event:
+      snprintf(p, size, "tool");
+      break;
+    case nuts_getopts_option_event:
+      if (ev->u.opt.option->lname != NULL)
+        n = snprintf(p, size, "--%s", ev->u.opt.option->lname);
+      else
+        n = snprintf(p, size, "-%c", ev->u.opt.option->sname);
+
+      if (ev->u.opt.value != NULL)
+        snprintf(p + n, size - n, "=%.*s", ev->len, ev->u.opt.value);
+      break;
+    case nuts_getopts_argument_event:
+      snprintf(p, size, "%.*s", ev->len, ev->u.arg);
+      break;
+    case nuts_getopts_error_event:
+      snprintf(p, size, "!%s:%.*s", error_names[ev->u.err.type], ev->u.err.option_len,
+        (ev->u.err.option != NULL) ? ev->u.err.option : "");
+      break;
+    case nuts_getopts_command_event:
+      snprintf(p, size, "cmd:%s", ev->u.cmd->name);
+      break;
+  }
+}
+
+// Splits cmdline into argv, the words are stored in buf.
+static int split(const char* cmdline, char* buf, char* argv[]) {
+  int argc;
+
+  snprintf(buf, MAX_LINE, "%s", cmdline);
+
+  if ((argc = nuts_getopts_split(buf, argv, MAX_ARGS)) < 0) {
+    fprintf(stderr, "cannot split %s\n", cmdline);
+    exit(1);
+  }
+
+  return argc;
+}
+
+/*
+ * Value conversions
+ */
+
+// Converts value as the argument of the option lname, returns OK or the error.
+static int convert(const char* lname, const char* value, union nuts_getopts_typed* out) {
+  char arg[MAX_LINE];
+  char* argv[] = { "check", arg, NULL };
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  int result = OK;
+
+  snprintf(arg, sizeof(arg), "--%s=%s", lname, value);
+
+  while (nuts_getopts(2, argv, value_options, 0, &state, &ev) == 0) {
+    if (ev.type == nuts_getopts_option_event)
+      *out = ev.u.opt.typed;
+    else if (ev.type == nuts_getopts_error_event)
+      result = ev.u.err.type;
+  }
+
+  return result;
+}
+
+static void check_result(const char* lname, const char* input, int result, int expected, int equal) {
+  char got[64], exp[64];
+
+  snprintf(got, sizeof(got), "%s", (result == OK) ? "ok" : error_names[result]);
+  snprintf(exp, sizeof(exp), "%s", (expected == OK) ? "ok" : error_names[expected]);
+
+  if (result == OK && expected == OK && !equal)
+    snprintf(got, sizeof(got), "wrong value");
+
+  check(lname, input, got, exp);
+}
+
+static void check_int64(void) {
+  static const struct {
+    const char* in;
+    int err;
+    int64_t out;
+  } cases[] = {
+    { "0",                     OK, 0 },
+    { "-1",                    OK, -1 },
+    { "+5",                    OK, 5 },
+    { "0x10",                  OK, 16 },
+    { "0X1f",                  OK, 31 },
+    { "-0x10",                 OK, -16 },
+    { "9223372036854775807",   OK, INT64_MAX },
+    { "-9223372036854775808",  OK, INT64_MIN },
+    { "9223372036854775808",   nuts_getopts_value_out_of_range },
+    { "-9223372036854775809",  nuts_getopts_value_out_of_range },
+    { "0x7fffffffffffffff",    OK, INT64_MAX },
+    { "0x8000000000000000",    nuts_getopts_value_out_of_range },
+    { "0x10000000000000000",   nuts_getopts_value_out_of_range },
+    { "0x",                    nuts_getopts_invalid_value },
+    { "0xg",                   nuts_getopts_invalid_value },
+    { "1a",                    nuts_getopts_invalid_value },
+    { "1.0",                   nuts_getopts_invalid_value },
+    { "-",                     nuts_getopts_invalid_value },
+    { " 1",                    nuts_getopts_invalid_value },
+  };
+  unsigned int i;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    union nuts_getopts_typed v = { 0 };
+    int result = convert("int", cases[i].in, &v);
+
+    check_result("int64", cases[i].in, result, cases[i].err, v.i64 == cases[i].out);
+  }
+}
+
+// Options with an uint64_t result: uint64, size and duration.
+static void check_uint64(void) {
+  static const struct {
+    const char* lname;
+    const char* in;
+    int err;
+    uint64_t out;
+  } cases[] = {
+    { "uint", "0",                      OK, 0 },
+    { "uint", "+7",                     OK, 7 },
+    { "uint", "18446744073709551615",   OK, UINT64_MAX },
+    { "uint", "18446744073709551616",   nuts_getopts_value_out_of_range },
+    { "uint", "0xffffffffffffffff",     OK, UINT64_MAX },
+    { "uint", "0x10000000000000000",    nuts_getopts_value_out_of_range },
+    { "uint", "-1",                     nuts_getopts_invalid_value },
+    { "uint", "0x",                     nuts_getopts_invalid_value },
+    { "uint", "12x",                    nuts_getopts_invalid_value },
+
+    { "size", "4096",                   OK, 4096 },
+    { "size", "4k",                     OK, 4096 },
+    { "size", "4K",                     OK, 4096 },
+    { "size", "4KB",                    OK, 4096 },
+    { "size", "4KiB",                   OK, 4096 },
+    { "size", "2G",                     OK, 2ull << 30 },
+    { "size", "1e",                     OK, 1ull << 60 },
+    { "size", "15E",                    OK, 15ull << 60 },
+    { "size", "16E",                    nuts_getopts_value_out_of_range },
+    { "size", "0x10K",                  OK, 16 << 10 },
+    { "size", "12B",                    OK, 12 },
+    { "size", "12iB",                   nuts_getopts_invalid_value },
+    { "size", "4Ki",                    nuts_getopts_invalid_value },
+    { "size", "4X",                     nuts_getopts_invalid_value },
+    { "size", "K",                      nuts_getopts_invalid_value },
+    { "size", "99999999999999999999",   nuts_getopts_value_out_of_range },
+
+    { "time", "10",                     OK, 10000000000ull },
+    { "time", "250ns",                  OK, 250 },
+    { "time", "3us",                    OK, 3000 },
+    { "time", "500ms",                  OK, 500000000ull },
+    { "time", "2s",                     OK, 2000000000ull },
+    { "time", "1h30m",                  OK, 5400000000000ull },
+    { "time", "1d",                     OK, 86400000000000ull },
+    { "time", "18446744073709551615ns", OK, UINT64_MAX },
+    { "time", "18446744073s",           OK, 18446744073000000000ull },
+    { "time", "18446744074s",           nuts_getopts_value_out_of_range },
+    { "time", "5x",                     nuts_getopts_invalid_value },
+    { "time", "ms",                     nuts_getopts_invalid_value },
+  };
+  unsigned int i;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    union nuts_getopts_typed v = { 0 };
+    int result = convert(cases[i].lname, cases[i].in, &v);
+
+    check_result(cases[i].lname, cases[i].in, result, cases[i].err, v.u64 == cases[i].out);
+  }
+}
+
+// The expected value is determined by strtod().
+static void check_double(void) {
+  static const struct {
+    const char* in;
+    int err;
+  } cases[] = {
+    { "0",            OK },
+    { "1.5",          OK },
+    { "-2e3",         OK },
+    { "+.5",          OK },
+    { "5.",           OK },
+    { "1E+2",         OK },
+    { "0.1",          OK },
+    { "646e-135",     OK },
+    { "31e202",       OK },
+    { "503618e-259",  OK },
+    { "1.7976931348623157e308", OK },
+    { "4.9e-324",     OK },
+    { "1e-400",       OK },
+    { "123456789012345678901234567890", OK },
+    { "1e309",        nuts_getopts_value_out_of_range },
+    { "1e100001",     nuts_getopts_value_out_of_range },
+    { "1e0x2",        nuts_getopts_invalid_value },
+    { "1e+0x1",       nuts_getopts_invalid_value },
+    { "1e",           nuts_getopts_invalid_value },
+    { "1e+",          nuts_getopts_invalid_value },
+    { ".",            nuts_getopts_invalid_value },
+    { "0x10",         nuts_getopts_invalid_value },
+    { "1,5",          nuts_getopts_invalid_value },
+    { "inf",          nuts_getopts_invalid_value },
+    { "nan",          nuts_getopts_invalid_value },
+  };
+  unsigned int i;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    union nuts_getopts_typed v = { 0 };
+    int result = convert("dbl", cases[i].in, &v);
+
+    check_result("double", cases[i].in, result, cases[i].err, v.f64 == strtod(cases[i].in, NULL));
+  }
+}
+
+static void check_bool(void) {
+  static const struct {
+    const char* in;
+    int err;
+    int out;
+  } cases[] = {
+    { "1",     OK, 1 },
+    { "true",  OK, 1 },
+    { "YES",   OK, 1 },
+    { "On",    OK, 1 },
+    { "0",     OK, 0 },
+    { "false", OK, 0 },
+    { "no",    OK, 0 },
+    { "OFF",   OK, 0 },
+    { "2",     nuts_getopts_invalid_value },
+    { "ye",    nuts_getopts_invalid_value },
+    { "yess",  nuts_getopts_invalid_value },
+  };
+  unsigned int i;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    union nuts_getopts_typed v = { 0 };
+    int result = convert("bool", cases[i].in, &v);
+
+    check_result("bool", cases[i].in, result, cases[i].err, v.b == cases[i].out);
+  }
+}
+
+/*
+ * nuts_getopts_split()
+ */
+
+static void check_split(void) {
+  static const struct {
+    const char* in;
+    int size;
+
+    /* The words separated by '|' or the errno value. */
+    const char* out;
+  } cases[] = {
+    { "",                              8, "" },
+    { "   ",                           8, "" },
+    { "a b  c",                        8, "a|b|c" },
+    { " \ta\n b ",                     8, "a|b" },
+    { "--name='John Doe' \"a b\"",     8, "--name=John Doe|a b" },
+    { "a\\ b c",                       8, "a b|c" },
+    { "'it''s'",                       8, "its" },
+    { "\"a\\\"b\" 'a\\b'",             8, "a\"b|a\\b" },
+    { "'' x",                          8, "|x" },
+    { "a b c",                         4, "a|b|c" },
+    { "a b c",                         3, "E2BIG" },
+    { "'unterminated",                 8, "EINVAL" },
+    { "\"unterminated",                8, "EINVAL" },
+    { "x\\",                           8, "EINVAL" },
+  };
+  unsigned int i;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    char buf[MAX_LINE], got[MAX_LINE] = "";
+    char* argv[MAX_ARGS];
+    int argc, j;
+
+    snprintf(buf, sizeof(buf), "%s", cases[i].in);
+
+    if ((argc = nuts_getopts_split(buf, argv, cases[i].size)) < 0) {
+      snprintf(got, sizeof(got), "%s", (errno == E2BIG) ? "E2BIG" : (errno == EINVAL) ? "EINVAL" : "?");
+    } else {
+      for (j = 0; j < argc; j++) {
+        if (j > 0)
+          strcat(got, "|");
+        strcat(got, argv[j]);
+      }
+
+      if (argv[argc] != NULL)
+        strcat(got, " (not terminated)");
+    }
+
+    check("split", cases[i].in, got, cases[i].out);
+  }
+}
+
+/*
+ * Streams
+ */
+
+struct chunked {
+  const char* data;
+  size_t len;
+  size_t pos;
+  size_t chunk;
+};
+
+// Returns at most chunk bytes per invocation, like a pipe.
+static long read_chunked(void* ctx, char* buf, size_t len) {
+  struct chunked* c = ctx;
+  size_t n = c->len - c->pos;
+
+  if (n > len)
+    n = len;
+  if (n > c->chunk)
+    n = c->chunk;
+
+  memcpy(buf, c->data + c->pos, n);
+  c->pos += n;
+
+  return n;
+}
+
+static void check_stream(void) {
+  static const struct {
+    const char* in;
+    size_t size;
+    const char* out;
+  } cases[] = {
+    { "-v\n--name=x\nfile\n",      16, "--verbose --name=x file" },
+    { "a\n\n\nb",                   16, "a b" },
+    { "abcdefg\nabcdefg",           8,  "abcdefg abcdefg" },
+    { "abcdefgh\nxy\n",             8,  "!too-long:abcdefgh xy" },
+    { "abcdefghijklmnopq\nxy",      8,  "!too-long:abcdefgh xy" },
+    { "-v\nabcdefghijkl",           8,  "--verbose !too-long:abcdefgh" },
+    { "--name\nx",                  8,  "!missing:--name x" },
+    { "",                           8,  "" },
+  };
+  static const size_t chunks[] = { 1, 3, 64 };
+  unsigned int i, j;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++) {
+      struct chunked c = { cases[i].in, strlen(cases[i].in), 0, chunks[j] };
+      char buf[64], got[MAX_LINE] = "";
+      nuts_getopts_stream stream;
+      struct nuts_getopts_event ev;
+
+      nuts_getopts_stream_init(&stream, read_chunked, &c, '\n', buf, cases[i].size);
+
+      while (nuts_getopts_stream_group(&stream, tool_groups, 0, &ev) == 0)
+        render(got, &ev);
+
+      check("stream", cases[i].in, got, cases[i].out);
+    }
+  }
+
+  // The arguments of a buffer are parsed in place.
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    char got[MAX_LINE] = "";
+    nuts_getopts_stream stream;
+    struct nuts_getopts_event ev;
+
+    if (strstr(cases[i].out, "too-long") != NULL)
+      continue;
+
+    nuts_getopts_stream_init_buffer(&stream, cases[i].in, strlen(cases[i].in), '\n');
+
+    while (nuts_getopts_stream_group(&stream, tool_groups, 0, &ev) == 0)
+      render(got, &ev);
+
+    check("stream buffer", cases[i].in, got, cases[i].out);
+  }
+}
+
+/*
+ * Response files
+ */
+
+static void write_file(const char* path, const char* content) {
+  FILE* f = fopen(path, "w");
+
+  if (f == NULL || fputs(content, f) < 0 || fclose(f) != 0) {
+    perror(path);
+    exit(1);
+  }
+}
+
+static void check_response_files(void) {
+  static const struct {
+    const char* path;
+    const char* content;
+  } files[] = {
+    { "a.rsp",     "-v @b.rsp x\n" },
+    { "b.rsp",     "--name=1\n\n  y\t@c.rsp" },
+    { "c.rsp",     "z" },
+    { "loop.rsp",  "w @loop.rsp" },
+    { "empty.rsp", "" },
+  };
+  static const struct {
+    const char* in;
+    const char* out;
+  } cases[] = {
+    { "tool @c.rsp",           "tool z" },
+    { "tool @a.rsp end",       "tool --verbose --name=1 y z x end" },
+    { "tool @empty.rsp end",   "tool end" },
+    { "tool @missing.rsp end", "tool !response:@missing.rsp end" },
+    { "tool @ x",              "tool @ x" },
+    { "tool a@b.rsp",          "tool a@b.rsp" },
+
+    // The nesting ends at the depth limit of 16.
+    { "tool @loop.rsp",
+      "tool w w w w w w w w w w w w w w w w !response:@loop.rsp" },
+  };
+  char dir[] = "/tmp/nuts-getopts-check-XXXXXX";
+  char cwd[MAX_LINE];
+  unsigned int i;
+
+  if (getcwd(cwd, sizeof(cwd)) == NULL || mkdtemp(dir) == NULL || chdir(dir) != 0) {
+    perror(dir);
+    exit(1);
+  }
+
+  for (i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+    write_file(files[i].path, files[i].content);
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    char buf[MAX_LINE], got[MAX_LINE] = "";
+    char* argv[MAX_ARGS];
+    int argc = split(cases[i].in, buf, argv);
+    nuts_getopts_state state = { 0 };
+    struct nuts_getopts_event ev;
+
+    while (nuts_getopts_group(argc, argv, tool_groups, nuts_getopts_response_files, &state, &ev) == 0)
+      render(got, &ev);
+
+    nuts_getopts_state_release(&state);
+
+    check("response files", cases[i].in, got, cases[i].out);
+  }
+
+  for (i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+    unlink(files[i].path);
+
+  if (chdir(cwd) != 0 || rmdir(dir) != 0)
+    perror(dir);
+}
+
+/*
+ * Abbreviations and commands
+ */
+
+static void check_abbreviations(void) {
+  static const struct nuts_getopts_option options[] = {
+    { 'v', "verbose", nuts_getopts_no_argument },
+    {  0,  "version", nuts_getopts_no_argument },
+    {  0,  "value",   nuts_getopts_required_argument },
+    {  0,  "all",     nuts_getopts_no_argument },
+    {  0,  "in",      nuts_getopts_no_argument },
+    {  0,  "input",   nuts_getopts_required_argument },
+    { 0 }
+  };
+  static const struct nuts_getopts_option_group groups[] = {
+    { .list = options },
+    { 0 }
+  };
+  static const struct {
+    const char* in;
+    int flags;
+    const char* out;
+  } cases[] = {
+    { "tool --verbose --all",    0, "tool --verbose --all" },
+    { "tool --verb",             0, "tool !invalid:--verb" },
+    { "tool --verb",             nuts_getopts_allow_abbreviations, "tool --verbose" },
+    { "tool --ver",              nuts_getopts_allow_abbreviations, "tool !ambiguous:--ver" },
+    { "tool --verbo --versi",    nuts_getopts_allow_abbreviations, "tool --verbose --version" },
+    { "tool --v",                nuts_getopts_allow_abbreviations, "tool !ambiguous:--v" },
+    { "tool --va=3",             nuts_getopts_allow_abbreviations, "tool --value=3" },
+    { "tool --a",                nuts_getopts_allow_abbreviations, "tool --all" },
+    { "tool --in --inp=x",       nuts_getopts_allow_abbreviations, "tool --in --input=x" },
+    { "tool --i",                nuts_getopts_allow_abbreviations, "tool !ambiguous:--i" },
+    { "tool --x --verbosely",    nuts_getopts_allow_abbreviations, "tool !invalid:--x !invalid:--verbosely" },
+    { "tool --=x",               nuts_getopts_allow_abbreviations, "tool !invalid:--" },
+    { "tool --=x --ver",         nuts_getopts_allow_abbreviations | nuts_getopts_ignore_unknown_options, "tool !ambiguous:--ver" },
+  };
+  nuts_getopts_spec* spec;
+  unsigned int i;
+
+  if ((spec = nuts_getopts_compile(groups)) == NULL) {
+    perror("nuts_getopts_compile");
+    exit(1);
+  }
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    char buf[MAX_LINE], got[MAX_LINE] = "";
+    char* argv[MAX_ARGS];
+    int argc = split(cases[i].in, buf, argv);
+    nuts_getopts_state state = { 0 };
+    struct nuts_getopts_event ev;
+
+    while (nuts_getopts_spec_parse(argc, argv, spec, cases[i].flags, &state, &ev) == 0)
+      render(got, &ev);
+
+    check("abbreviations", cases[i].in, got, cases[i].out);
+  }
+
+  nuts_getopts_spec_free(spec);
+}
+
+static void check_commands(void) {
+  static const struct nuts_getopts_option one_options[] = {
+    { 'f', "file", nuts_getopts_required_argument },
+    { 0 }
+  };
+  static const struct nuts_getopts_option_group one_groups[] = {
+    { .list = one_options },
+    { 0 }
+  };
+  static const struct nuts_getopts_command commands[] = {
+    { .name = "one", .groups = one_groups },
+    { .name = "two" },
+    { 0 }
+  };
+  static const struct {
+    const char* in;
+    int flags;
+    const char* out;
+  } cases[] = {
+    { "tool -v one -fx arg",  0, "tool --verbose cmd:one --file=x arg" },
+    { "tool -fx",             0, "tool !invalid:-f" },
+    { "tool two one",         0, "tool cmd:two one" },
+    { "tool file one",        0, "tool file one" },
+    { "tool -v file",         nuts_getopts_skip_arguments, "tool --verbose" },
+    { "tool one file",        nuts_getopts_skip_arguments, "tool cmd:one" },
+  };
+  nuts_getopts_spec* spec;
+  nuts_getopts_commands* cmds;
+  unsigned int i;
+
+  if ((spec = nuts_getopts_compile(tool_groups)) == NULL || (cmds = nuts_getopts_commands_compile(commands)) == NULL) {
+    perror("nuts_getopts_compile");
+    exit(1);
+  }
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    char buf[MAX_LINE], got[MAX_LINE] = "";
+    char* argv[MAX_ARGS];
+    int argc = split(cases[i].in, buf, argv);
+    nuts_getopts_state state = { 0 };
+    struct nuts_getopts_event ev;
+
+    while (nuts_getopts_command_parse(argc, argv, spec, cmds, cases[i].flags, &state, &ev) == 0)
+      render(got, &ev);
+
+    check("commands", cases[i].in, got, cases[i].out);
+  }
+
+  nuts_getopts_commands_free(cmds);
+  nuts_getopts_spec_free(spec);
+}
+
+int main(int argc, char* argv[]) {
+  check_int64();
+  check_uint64();
+  check_double();
+  check_bool();
+  check_split();
+  check_stream();
+  check_response_files();
+  check_abbreviations();
+  check_commands();
+
+  printf("%ld failures\n", failures);
+
+  return (failures == 0) ? 0 : 1;
+}
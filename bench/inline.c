@@ -0,0 +1,133 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * Compares the parser compiled into the caller (single-header build) with
+ * the parser of the static library.
+ *
+ * Both variants parse the same command line with the same constant option
+ * array, see inline_parse.c. The variants are measured alternately for a
+ * number of rounds and the best time of each is reported, so a disturbance
+ * of the machine does not favor one of them.
+ *
+ * Usage: nuts-getopts-inline-bench [-a<args>] [-t<msec>]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <nuts-getopts.h>
+
+// Number of measurements of each variant.
+#define ROUNDS 5
+
+long parse_library(int argc, char* argv[], int flags);
+long parse_inlined(int argc, char* argv[], int flags);
+
+static const char* args[] = {
+  "-v", "--quiet", "-oout.o", "--output=out.o", "-I/usr/include",
+  "--include=src", "-DNDEBUG", "--define=X=1", "-j8", "--jobs=8", "-f",
+  "--dry-run", "file.c", "--force"
+};
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Returns the time per argument, chars receives the result of parse.
+static double measure(long (*parse)(int, char**, int), int argc, char* argv[], double min_ns, long* chars) {
+  double start = now(), elapsed;
+  long runs = 0, sum = 0;
+
+  do {
+    sum += parse(argc, argv, 0);
+    runs++;
+  } while ((elapsed = now() - start) < min_ns);
+
+  *chars = sum / runs;
+
+  return elapsed / ((double)runs * argc);
+}
+
+int main(int argc, char* argv[]) {
+  const struct nuts_getopts_option options[] = {
+    { 'a', "args", nuts_getopts_required_argument },
+    { 't', "time", nuts_getopts_required_argument },
+    { 0 }
+  };
+  double library = 0, inlined = 0;
+  long library_chars, inlined_chars;
+  int nargs = 4096, msec = 200, i;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  char** cmdline;
+
+  while (nuts_getopts(argc, argv, options, 0, &state, &ev) == 0) {
+    if (ev.type == nuts_getopts_option_event) {
+      int value = atoi(ev.u.opt.value);
+
+      switch (ev.u.opt.option->sname) {
+        case 'a': nargs = value; break;
+        case 't': msec = value; break;
+      }
+    } else if (ev.type == nuts_getopts_error_event) {
+      fprintf(stderr, "usage: %s [-a<args>] [-t<msec>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  cmdline = calloc(nargs + 1, sizeof(char*));
+  cmdline[0] = "/usr/bin/bench";
+
+  for (i = 1; i < nargs; i++)
+    cmdline[i] = (char*)args[i % (sizeof(args) / sizeof(args[0]))];
+
+  printf("%-8s %12s %12s\n", "parser", "ns/arg", "chars");
+
+  for (i = 0; i < ROUNDS; i++) {
+    double ns = measure(parse_library, nargs, cmdline, msec * 1e6, &library_chars);
+
+    if (i == 0 || ns < library)
+      library = ns;
+
+    ns = measure(parse_inlined, nargs, cmdline, msec * 1e6, &inlined_chars);
+
+    if (i == 0 || ns < inlined)
+      inlined = ns;
+  }
+
+  printf("%-8s %12.2f %12ld\n", "library", library, library_chars);
+  printf("%-8s %12.2f %12ld\n", "inlined", inlined, inlined_chars);
+
+  free(cmdline);
+
+  return 0;
+}
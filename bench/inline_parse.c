@@ -0,0 +1,66 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * The parser loop of nuts-getopts-inline-bench.
+ *
+ * The file is compiled twice: as parse_library() against nuts-getopts.h and
+ * the library, and as parse_inlined() with the implementation of
+ * nuts-getopts-single.h compiled in (NUTS_GETOPTS_IMPLEMENTATION).
+ */
+
+#ifdef NUTS_GETOPTS_IMPLEMENTATION
+#include <nuts-getopts-single.h>
+#define PARSE parse_inlined
+#else
+#include <nuts-getopts.h>
+#define PARSE parse_library
+#endif
+
+long PARSE(int argc, char* argv[], int flags);
+
+// The options of a typical tool, constant, so the compiler can fold them
+// into the parser if it is inlined.
+static const struct nuts_getopts_option options[] = {
+  { 'v', "verbose", nuts_getopts_no_argument },
+  { 'q', "quiet",   nuts_getopts_no_argument },
+  { 'o', "output",  nuts_getopts_required_argument },
+  { 'I', "include", nuts_getopts_required_argument },
+  { 'D', "define",  nuts_getopts_required_argument },
+  { 'j', "jobs",    nuts_getopts_required_argument },
+  { 'f', "force",   nuts_getopts_no_argument },
+  {  0,  "dry-run", nuts_getopts_no_argument },
+  { 0 }
+};
+
+long PARSE(int argc, char* argv[], int flags) {
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  long n = 0;
+
+  while (nuts_getopts(argc, argv, options, flags, &state, &ev) == 0)
+    n += ev.len;
+
+  return n;
+}
@@ -0,0 +1,202 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * Stress and throughput test of shared specs.
+ *
+ * Worker threads parse a command line with a nuts_getopts_shared spec in a
+ * loop, while another thread keeps replacing the spec. The two specs differ
+ * in one option (--alpha resp. --beta), each parser run must see exactly one
+ * of them.
+ *
+ * Usage: nuts-getopts-stress [-w<workers>] [-t<msec>] [-s<usec between swaps>]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nuts-getopts.h>
+
+#define MAX_WORKERS 64
+
+static const struct nuts_getopts_option common_options[] = {
+  { 'c', "common",  nuts_getopts_required_argument },
+  { 'v', "verbose", nuts_getopts_no_argument },
+  { 0 }
+};
+
+static const struct nuts_getopts_option alpha_options[] = {
+  {  0,  "alpha",   nuts_getopts_no_argument },
+  { 0 }
+};
+
+static const struct nuts_getopts_option beta_options[] = {
+  {  0,  "beta",    nuts_getopts_no_argument },
+  { 0 }
+};
+
+static const struct nuts_getopts_option_group alpha_groups[] = {
+  { .list = common_options },
+  { .list = alpha_options },
+  { 0 }
+};
+
+static const struct nuts_getopts_option_group beta_groups[] = {
+  { .list = common_options },
+  { .list = beta_options },
+  { 0 }
+};
+
+static char* cmdline[] = {
+  "/usr/bin/server", "--common=1", "--alpha", "-v", "--beta", "file", "-cx"
+};
+
+struct worker {
+  pthread_t thread;
+  nuts_getopts_shared* shared;
+  volatile int* stop;
+  long parses;
+  long errors;
+};
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void* run_worker(void* arg) {
+  struct worker* w = arg;
+  const int argc = sizeof(cmdline) / sizeof(cmdline[0]);
+
+  while (!__atomic_load_n(w->stop, __ATOMIC_RELAXED)) {
+    nuts_getopts_state state = { 0 };
+    struct nuts_getopts_event ev;
+    int ticket, alpha = 0, beta = 0, events = 0;
+    const nuts_getopts_spec* spec = nuts_getopts_shared_acquire(w->shared, &ticket);
+
+    while (nuts_getopts_spec_parse(argc, cmdline, spec, nuts_getopts_ignore_unknown_options, &state, &ev) == 0) {
+      if (ev.type == nuts_getopts_option_event) {
+        alpha += (ev.u.opt.option == &alpha_options[0]);
+        beta += (ev.u.opt.option == &beta_options[0]);
+      }
+      events++;
+    }
+
+    nuts_getopts_shared_release(w->shared, ticket);
+
+    // tool, 2 common options, one of alpha/beta, -v and the argument
+    if (alpha + beta != 1 || events != 6)
+      w->errors++;
+
+    w->parses++;
+  }
+
+  return NULL;
+}
+
+int main(int argc, char* argv[]) {
+  const struct nuts_getopts_option options[] = {
+    { 'w', "workers", nuts_getopts_required_argument, nuts_getopts_int64_value },
+    { 't', "time",    nuts_getopts_required_argument, nuts_getopts_int64_value },
+    { 's', "swap",    nuts_getopts_required_argument, nuts_getopts_int64_value },
+    { 0 }
+  };
+  struct worker workers[MAX_WORKERS];
+  int nworkers = 4, msec = 1000, usec = 100, i;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  nuts_getopts_shared* shared;
+  volatile int stop = 0;
+  long swaps = 0, parses = 0, errors = 0;
+  double start, elapsed;
+
+  while (nuts_getopts(argc, argv, options, 0, &state, &ev) == 0) {
+    if (ev.type == nuts_getopts_option_event) {
+      int value = ev.u.opt.typed.i64;
+
+      switch (ev.u.opt.option->sname) {
+        case 'w': nworkers = value; break;
+        case 't': msec = value; break;
+        case 's': usec = value; break;
+      }
+    } else if (ev.type == nuts_getopts_error_event) {
+      fprintf(stderr, "usage: %s [-w<workers>] [-t<msec>] [-s<usec>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (nworkers < 1 || nworkers > MAX_WORKERS) {
+    fprintf(stderr, "%s: workers must be between 1 and %d\n", argv[0], MAX_WORKERS);
+    return 1;
+  }
+
+  if ((shared = nuts_getopts_shared_new(nuts_getopts_compile(alpha_groups))) == NULL) {
+    perror("nuts_getopts_shared_new");
+    return 1;
+  }
+
+  for (i = 0; i < nworkers; i++) {
+    memset(&workers[i], 0, sizeof(struct worker));
+    workers[i].shared = shared;
+    workers[i].stop = &stop;
+    pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]);
+  }
+
+  // The main thread keeps swapping the spec.
+  start = now();
+
+  while ((elapsed = now() - start) < msec * 1e6) {
+    const struct nuts_getopts_option_group* groups = (swaps % 2 == 0) ? beta_groups : alpha_groups;
+    struct timespec ts = { 0, usec * 1000L };
+
+    nuts_getopts_spec_free(nuts_getopts_shared_swap(shared, nuts_getopts_compile(groups)));
+    swaps++;
+
+    if (usec > 0)
+      nanosleep(&ts, NULL);
+  }
+
+  __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+  for (i = 0; i < nworkers; i++) {
+    pthread_join(workers[i].thread, NULL);
+    parses += workers[i].parses;
+    errors += workers[i].errors;
+  }
+
+  nuts_getopts_shared_free(shared);
+
+  printf("%-8s %10s %10s %14s %8s\n", "workers", "swaps", "parses", "parses/s", "errors");
+  printf("%-8d %10ld %10ld %14.0f %8ld\n", nworkers, swaps, parses, parses / (elapsed / 1e9), errors);
+
+  return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * Checks nuts_getopts_suggest() against a brute-force scan.
+ *
+ * A spec with random long names (every 100th name is longer than the distance
+ * row on the stack) is queried with misspelled names. For each query the
+ * distance to every name is computed and the expected options are selected
+ * by distance and spec order.
+ *
+ * Usage: nuts-getopts-suggest-check [-n<names>] [-q<queries>] [-s<seed>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nuts-getopts.h>
+
+// Longest generated name and query.
+#define MAX_NAME 192
+
+// Number of options requested per query.
+#define MAX_MATCHES 5
+
+static const char alphabet[] = "abcdefgh-";
+
+static int min3(int a, int b, int c) {
+  int m = (a < b) ? a : b;
+  return (m < c) ? m : c;
+}
+
+// Textbook Levenshtein distance with a full matrix row per character of a.
+static int distance(const char* a, int la, const char* b, int lb) {
+  int prev[MAX_NAME + 1], cur[MAX_NAME + 1];
+  int i, j;
+
+  for (j = 0; j <= lb; j++)
+    prev[j] = j;
+
+  for (i = 1; i <= la; i++) {
+    cur[0] = i;
+
+    for (j = 1; j <= lb; j++)
+      cur[j] = min3(prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (a[i - 1] != b[j - 1]));
+
+    memcpy(prev, cur, (lb + 1) * sizeof(int));
+  }
+
+  return prev[lb];
+}
+
+static int mk_name(char* buf, int i) {
+  int len = (i % 100 == 99) ? 130 + rand() % 40 : 1 + rand() % 12, k;
+
+  // No leading dash, it would be stripped from a query.
+  buf[0] = alphabet[rand() % 8];
+
+  for (k = 1; k < len; k++)
+    buf[k] = alphabet[rand() % (sizeof(alphabet) - 1)];
+
+  buf[len] = '\0';
+
+  return len;
+}
+
+// Applies up to three random edits to name.
+static int misspell(char* buf, const char* name) {
+  int len = strlen(name), edits = rand() % 4, k;
+
+  memcpy(buf, name, len + 1);
+
+  for (k = 0; k < edits; k++) {
+    int pos = (len > 0) ? rand() % len : 0;
+
+    switch (rand() % 3) {
+      case 0:
+        if (len < MAX_NAME - 1) {
+          memmove(buf + pos + 1, buf + pos, len - pos + 1);
+          buf[pos] = alphabet[rand() % 8];
+          len++;
+        }
+        break;
+      case 1:
+        if (len > 1) {
+          memmove(buf + pos, buf + pos + 1, len - pos);
+          len--;
+        }
+        break;
+      default:
+        buf[pos] = alphabet[rand() % 8];
+        break;
+    }
+  }
+
+  return len;
+}
+
+int main(int argc, char* argv[]) {
+  const struct nuts_getopts_option options[] = {
+    { 'n', "names",   nuts_getopts_required_argument, nuts_getopts_int64_value },
+    { 'q', "queries", nuts_getopts_required_argument, nuts_getopts_int64_value },
+    { 's', "seed",    nuts_getopts_required_argument, nuts_getopts_int64_value },
+    { 0 }
+  };
+  int nnames = 5000, nqueries = 2000, seed = 1, i, q;
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event ev;
+  struct nuts_getopts_option* names;
+  struct nuts_getopts_option_group groups[2] = { { 0 } };
+  nuts_getopts_spec* spec;
+  nuts_getopts_suggestions* suggestions;
+  char* pool;
+  long errors = 0;
+
+  while (nuts_getopts(argc, argv, options, 0, &state, &ev) == 0) {
+    if (ev.type == nuts_getopts_option_event) {
+      int value = ev.u.opt.typed.i64;
+
+      switch (ev.u.opt.option->sname) {
+        case 'n': nnames = value; break;
+        case 'q': nqueries = value; break;
+        case 's': seed = value; break;
+      }
+    } else if (ev.type == nuts_getopts_error_event) {
+      fprintf(stderr, "usage: %s [-n<names>] [-q<queries>] [-s<seed>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (nnames < 1) {
+    fprintf(stderr, "%s: at least one name is required\n", argv[0]);
+    return 1;
+  }
+
+  srand(seed);
+
+  names = calloc(nnames + 1, sizeof(struct nuts_getopts_option));
+  pool = malloc(nnames * (MAX_NAME + 1));
+
+  // The names must be unique, otherwise the spec is rejected.
+  for (i = 0; i < nnames; i++) {
+    char* name = pool + i * (MAX_NAME + 1);
+    int k;
+
+    do {
+      mk_name(name, i);
+
+      for (k = 0; k < i && strcmp(names[k].lname, name) != 0; k++);
+    } while (k < i);
+
+    names[i].lname = name;
+  }
+
+  groups[0].list = names;
+
+  if ((spec = nuts_getopts_compile(groups)) == NULL || (suggestions = nuts_getopts_suggestions_compile(spec)) == NULL) {
+    perror("nuts_getopts_compile");
+    return 1;
+  }
+
+  for (q = 0; q < nqueries; q++) {
+    const struct nuts_getopts_option* found[MAX_MATCHES];
+    const struct nuts_getopts_option* expected[MAX_MATCHES];
+    int dists[MAX_MATCHES];
+    int size = 1 + rand() % MAX_MATCHES, max_distance = rand() % 4;
+    int len, nfound, nexpected = 0;
+    char query[MAX_NAME + 16];
+    const char* name;
+
+    // Queries are passed like the option of an error event, in part.
+    strcpy(query, "--");
+    len = misspell(query + 2, names[rand() % nnames].lname);
+
+    if (rand() % 2 == 0)
+      len += sprintf(query + 2 + len, "=value");
+
+    nfound = nuts_getopts_suggest(suggestions, query, len + 2, max_distance, found, size);
+
+    // Like nuts_getopts_suggest(), compare without dashes and "=value". A
+    // misspelled name may start with a dash of its own.
+    name = query + strspn(query, "-");
+    len = strcspn(name, "=");
+
+    // Insertion into the list ordered by distance and spec order, scanning
+    // in spec order keeps the order of equal distances.
+    for (i = 0; i < nnames; i++) {
+      int d = distance(name, len, names[i].lname, strlen(names[i].lname)), k;
+
+      if (d > max_distance || (nexpected == size && d >= dists[size - 1]))
+        continue;
+
+      if (nexpected < size)
+        nexpected++;
+
+      for (k = nexpected - 1; k > 0 && dists[k - 1] > d; k--) {
+        expected[k] = expected[k - 1];
+        dists[k] = dists[k - 1];
+      }
+
+      expected[k] = &names[i];
+      dists[k] = d;
+    }
+
+    if (nfound != nexpected || memcmp(found, expected, nfound * sizeof(found[0])) != 0) {
+      fprintf(stderr, "mismatch for %s: %d options found, %d expected\n", query, nfound, nexpected);
+      errors++;
+    }
+  }
+
+  nuts_getopts_suggestions_free(suggestions);
+  nuts_getopts_spec_free(spec);
+  free(pool);
+  free(names);
+
+  printf("%-8s %10s %8s\n", "names", "queries", "errors");
+  printf("%-8d %10d %8ld\n", nnames, nqueries, errors);
+
+  return (errors == 0) ? 0 : 1;
+}
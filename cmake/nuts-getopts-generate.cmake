@@ -0,0 +1,49 @@
+##
+# MIT License
+#
+# Copyright (c) 2020 Robin Doer
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+##
+
+# nuts_getopts_generate(<target> <spec>)
+#
+# Generates the option table and lookup of a parser from the spec file <spec>
+# and adds the generated source to <target>. The symbols and the header are
+# named after the spec file, e.g. tool.spec creates tool.h with tool_options
+# and tool_lookup.
+function(nuts_getopts_generate target spec)
+  get_filename_component(spec_path ${spec} ABSOLUTE)
+  get_filename_component(name ${spec} NAME_WE)
+  string(REGEX REPLACE "[^A-Za-z0-9_]" "_" name ${name})
+
+  set(source ${CMAKE_CURRENT_BINARY_DIR}/${name}.c)
+  set(header ${CMAKE_CURRENT_BINARY_DIR}/${name}.h)
+
+  add_custom_command(
+    OUTPUT ${source} ${header}
+    COMMAND nuts-getopts-gen ${name} ${spec_path} ${source} ${header}
+    DEPENDS nuts-getopts-gen ${spec_path}
+    COMMENT "Generating nuts-getopts parser ${name}"
+    VERBATIM
+  )
+
+  target_sources(${target} PRIVATE ${source} ${header})
+  target_include_directories(${target} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+endfunction()
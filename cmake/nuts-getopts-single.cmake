@@ -0,0 +1,91 @@
+##
+# MIT License
+#
+# Copyright (c) 2020 Robin Doer
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+##
+
+# Creates the single header of nuts-getopts, run with cmake -P.
+#
+# Variables:
+#   SOURCE_DIR  Directory of the library sources (src).
+#   SOURCES     The translation units of the library, a ;-list.
+#   OUTPUT      The header to create.
+#
+# The header consists of nuts-getopts.h and, guarded by
+# NUTS_GETOPTS_IMPLEMENTATION, of private.h and all translation units.
+
+set(LICENSE_END "*****************************************************************************/\n")
+
+# Reads file and strips the license header.
+function(read_source file var)
+  file(READ ${SOURCE_DIR}/${file} content)
+
+  string(FIND "${content}" "${LICENSE_END}" pos)
+  string(LENGTH "${LICENSE_END}" len)
+  math(EXPR pos "${pos} + ${len}")
+  string(SUBSTRING "${content}" ${pos} -1 content)
+
+  # The headers are part of the single header, the feature test macro is
+  # defined in front of all system headers.
+  string(REGEX REPLACE "#include \"(private|nuts-getopts)\\.h\"\n" "" content "${content}")
+  string(REGEX REPLACE "#define _POSIX_C_SOURCE [0-9L]+\n" "" content "${content}")
+
+  set(${var} "${content}" PARENT_SCOPE)
+endfunction()
+
+file(READ ${SOURCE_DIR}/nuts-getopts.h header)
+string(FIND "${header}" "${LICENSE_END}" pos)
+string(SUBSTRING "${header}" 0 ${pos} license)
+
+read_source(nuts-getopts.h public)
+read_source(private.h private)
+
+set(single "${license}${LICENSE_END}
+/*
+ * Single header of nuts-getopts, generated from the sources. Do not edit.
+ *
+ * Define NUTS_GETOPTS_IMPLEMENTATION in front of the include to compile the
+ * implementation into the translation unit.
+ */
+
+#if defined(NUTS_GETOPTS_IMPLEMENTATION) && !defined(NUTS_GETOPTS_API)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#define NUTS_GETOPTS_API static inline
+#endif
+${public}
+#if defined(NUTS_GETOPTS_IMPLEMENTATION) && !defined(NUTS_GETOPTS_SINGLE_IMPLEMENTATION)
+#define NUTS_GETOPTS_SINGLE_IMPLEMENTATION
+${private}")
+
+foreach(source ${SOURCES})
+  read_source(${source} content)
+  set(single "${single}
+/* ${source} */
+${content}")
+endforeach()
+
+set(single "${single}
+#endif  /* NUTS_GETOPTS_IMPLEMENTATION */
+")
+
+file(WRITE ${OUTPUT} "${single}")
@@ -68,6 +68,14 @@ static void handle_error_event(const struct nuts_getopts_event* ev) {
       fprintf(stderr, "error: needless value for option %.*s\n",
         ev->u.err.option_len, ev->u.err.option);
       break;
+    case nuts_getopts_invalid_response_file:
+      fprintf(stderr, "error: cannot read response file %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
+    default:
+      fprintf(stderr, "error: invalid argument %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
   }
 }
 
@@ -112,6 +120,9 @@ int main(int argc, char* argv[]) {
       case nuts_getopts_error_event:
         handle_error_event(&ev);
         return 1;
+      case nuts_getopts_command_event:
+        // Not reported by nuts_getopts().
+        break;
     }
   }
 
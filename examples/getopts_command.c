@@ -0,0 +1,221 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @example getopts_command.c
+ *
+ * This is an example of how to use nuts_getopts_command_parse().
+ *
+ * The tool is the same as in getopts_group.c, but the action specific
+ * options are selected by the parser itself. The command line is parsed in a
+ * single pass. The options of the `two` command are resolved on demand. For
+ * a misspelled global option similar options are suggested.
+ *
+ * @code{.sh}
+ * $ nuts-getopts-command-example one -v1 --quiet -fx
+ * tool: nuts-getopts-command-example
+ * command: one
+ * option: v/verbose, arg: 1
+ * option: /quiet, no-arg
+ * option: f/file, arg: x
+ *
+ * $ nuts-getopts-command-example two -g
+ * tool: nuts-getopts-command-example
+ * command: two
+ * option: g/global, no-arg
+ *
+ * $ nuts-getopts-command-example -g two
+ * tool: nuts-getopts-command-example
+ * error: invalid option -g
+ *
+ * $ nuts-getopts-command-example three -g
+ * tool: nuts-getopts-command-example
+ * argument: three
+ * error: invalid option -g
+ *
+ * $ nuts-getopts-command-example --verbsoe=1
+ * tool: nuts-getopts-command-example
+ * error: invalid option --verbsoe
+ * did you mean --verbose?
+ * @endcode
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <nuts-getopts.h>
+
+// Resolves the options of a command on demand.
+// Here the options are simply stored in the ctx member of the command.
+static const struct nuts_getopts_option_group* resolve_command(const struct nuts_getopts_command* command) {
+  return command->ctx;
+}
+
+static void handle_tool_event(const struct nuts_getopts_event* ev) {
+  printf("tool: %s\n", ev->u.tool);
+}
+
+static void handle_command_event(const struct nuts_getopts_event* ev) {
+  printf("command: %s\n", ev->u.cmd->name);
+}
+
+static void handle_option_event(const struct nuts_getopts_event* ev) {
+  // The options which was selected.
+  const struct nuts_getopts_option* option = ev->u.opt.option;
+
+  if (option->arg == nuts_getopts_required_argument) {
+    printf("option: %c/%s, arg: %s\n",
+      option->sname, option->lname, ev->u.opt.value);
+  } else {
+    printf("option: %c/%s, no-arg\n",
+      option->sname, option->lname);
+  }
+}
+
+static void handle_argument_event(const struct nuts_getopts_event* ev) {
+  printf("argument: %s\n", ev->u.arg);
+}
+
+static void handle_error_event(const struct nuts_getopts_event* ev, const nuts_getopts_suggestions* suggestions) {
+  const struct nuts_getopts_option* similar[3];
+  int n, i;
+
+  switch (ev->u.err.type) {
+    case nuts_getopts_invalid_option:
+      fprintf(stderr, "error: invalid option %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+
+      // Suggest up to three options, which differ in two characters at most.
+      n = nuts_getopts_suggest(suggestions, ev->u.err.option, ev->u.err.option_len, 2, similar, 3);
+
+      for (i = 0; i < n; i++)
+        fprintf(stderr, "did you mean --%s?\n", similar[i]->lname);
+      break;
+    case nuts_getopts_missing_value:
+      fprintf(stderr, "error: missing value for option %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
+    case nuts_getopts_needless_value:
+      fprintf(stderr, "error: needless value for option %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
+    case nuts_getopts_invalid_command:
+      fprintf(stderr, "error: cannot resolve command %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
+    default:
+      fprintf(stderr, "error: invalid argument %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // The global options, valid with and without a command.
+  const struct nuts_getopts_option global_options[] = {
+    { 'v', "verbose",  nuts_getopts_required_argument },
+    {  0,  "quiet",    nuts_getopts_no_argument },
+    { 0 }
+  };
+  const struct nuts_getopts_option_group global_group[] = {
+    { .list = global_options },
+    { 0 }
+  };
+
+  // The options of the `one` command.
+  const struct nuts_getopts_option one_options[] = {
+    { 'f', "file", nuts_getopts_required_argument },
+    { 0 }
+  };
+  const struct nuts_getopts_option_group one_group[] = {
+    { .list = one_options },
+    { 0 }
+  };
+
+  // The options of the `two` command.
+  const struct nuts_getopts_option two_options[] = {
+    { 'g', "global", nuts_getopts_no_argument },
+    { 0 }
+  };
+  const struct nuts_getopts_option_group two_group[] = {
+    { .list = two_options },
+    { 0 }
+  };
+
+  // Maps the command names to their options.
+  // The options of `two` are compiled only, if the command is selected.
+  // The last element has a NULL name.
+  const struct nuts_getopts_command commands[] = {
+    { .name = "one", .groups = one_group },
+    { .name = "two", .resolve = resolve_command, .ctx = (void*)two_group },
+    { NULL }
+  };
+
+  // The state of the parser.
+  // Must be initialized with zeros before the first invocation of
+  // nuts_getopts_command_parse(). It keeps track of the selected command.
+  nuts_getopts_state state = { 0 };
+
+  // The event the parser emits.
+  struct nuts_getopts_event ev = { 0 };
+
+  nuts_getopts_spec* spec = nuts_getopts_compile(global_group);
+  nuts_getopts_commands* cmds = nuts_getopts_commands_compile(commands);
+  nuts_getopts_suggestions* suggestions = (spec != NULL) ? nuts_getopts_suggestions_compile(spec) : NULL;
+  int result = 0;
+
+  if (spec == NULL || cmds == NULL || suggestions == NULL) {
+    perror("nuts_getopts_compile");
+    result = 1;
+  }
+
+  // Call the parser in a loop.
+  while (result == 0 && nuts_getopts_command_parse(argc, argv, spec, cmds, 0, &state, &ev) == 0) {
+    // Depending on the event-type call a related handler.
+    switch (ev.type) {
+      case nuts_getopts_tool_event:
+        handle_tool_event(&ev);
+        break;
+      case nuts_getopts_command_event:
+        handle_command_event(&ev);
+        break;
+      case nuts_getopts_option_event:
+        handle_option_event(&ev);
+        break;
+      case nuts_getopts_argument_event:
+        handle_argument_event(&ev);
+        break;
+      case nuts_getopts_error_event:
+        handle_error_event(&ev, suggestions);
+        result = 1;
+        break;
+    }
+  }
+
+  nuts_getopts_suggestions_free(suggestions);
+  nuts_getopts_commands_free(cmds);
+  nuts_getopts_spec_free(spec);
+
+  return result;
+}
@@ -126,6 +126,14 @@ static void handle_error_event(const struct nuts_getopts_event* ev) {
       fprintf(stderr, "error: needless value for option %.*s\n",
         ev->u.err.option_len, ev->u.err.option);
       break;
+    case nuts_getopts_invalid_response_file:
+      fprintf(stderr, "error: cannot read response file %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
+    default:
+      fprintf(stderr, "error: invalid argument %.*s\n",
+        ev->u.err.option_len, ev->u.err.option);
+      break;
   }
 }
 
@@ -190,7 +198,8 @@ int main(int argc, char* argv[]) {
 
   // First we want to extract the action argument from the command line.
   // For this, we ignore all options and are only interested in arguments.
-  while (nuts_getopts(argc, argv, NULL, nuts_getopts_ignore_unknown_options, &state, &ev) == 0) {
+  // The tool event is filtered out by the parser itself.
+  while (nuts_getopts(argc, argv, NULL, nuts_getopts_ignore_unknown_options | nuts_getopts_skip_tool, &state, &ev) == 0) {
     if (ev.type == nuts_getopts_argument_event) {
       // The first argument is the action.
       action = ev.u.arg;
@@ -230,6 +239,9 @@ int main(int argc, char* argv[]) {
       case nuts_getopts_error_event:
         handle_error_event(&ev);
         return 1;
+      case nuts_getopts_command_event:
+        // Not reported by nuts_getopts_group().
+        break;
     }
   }
 
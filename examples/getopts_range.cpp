@@ -0,0 +1,86 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @example getopts_range.cpp
+ *
+ * This is an example of how to iterate over the events with
+ * nuts::getopts::parse().
+ *
+ * Response files are enabled. The strings read from a response file are not
+ * NUL-terminated, but the `std::string_view` of an event carries its length.
+ *
+ * @code{.sh}
+ * $ echo "--verbose=2 makeitso" > args.txt
+ * $ nuts-getopts-range-example --quiet @args.txt
+ * tool: nuts-getopts-range-example
+ * option: /quiet, no-arg
+ * option: v/verbose, arg: 2
+ * argument: makeitso
+ * @endcode
+ */
+
+#include <iostream>
+
+#include "nuts-getopts.hpp"
+
+int main(int argc, char* argv[]) {
+  const nuts_getopts_option options[] = {
+    { 'v', "verbose", nuts_getopts_required_argument },
+    {  0,  "quiet",   nuts_getopts_no_argument },
+    { 0 }
+  };
+
+  // Each iteration invokes nuts_getopts() once, the state of the parser is
+  // owned by the range.
+  for (auto ev : nuts::getopts::parse(argc, argv, options, nuts_getopts_response_files)) {
+    switch (ev.type()) {
+      case nuts_getopts_tool_event:
+        std::cout << "tool: " << ev.str() << "\n";
+        break;
+      case nuts_getopts_option_event: {
+        const nuts_getopts_option* option = ev.option();
+
+        std::cout << "option: " << (option->sname ? option->sname : ' ') << "/" << (option->lname ? option->lname : "");
+
+        if (option->arg == nuts_getopts_required_argument)
+          std::cout << ", arg: " << ev.str() << "\n";
+        else
+          std::cout << ", no-arg\n";
+        break;
+      }
+      case nuts_getopts_argument_event:
+        std::cout << "argument: " << ev.str() << "\n";
+        break;
+      case nuts_getopts_error_event:
+        std::cerr << "error: invalid argument " << ev.str() << "\n";
+        return 1;
+      case nuts_getopts_command_event:
+        // Not reported by nuts_getopts().
+        break;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @example getopts_spec.cpp
+ *
+ * This is an example of how to use a nuts::getopts::spec.
+ *
+ * The option table is checked and indexed at compile time. Declaring two
+ * options with the same name fails to compile.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "nuts-getopts.hpp"
+
+static constexpr nuts::getopts::spec options{{
+  { 'v', "verbose", nuts_getopts_required_argument, nuts_getopts_int64_value },
+  {  0,  "quiet",   nuts_getopts_no_argument },
+  { 'f', nullptr,   nuts_getopts_required_argument }
+}};
+
+// The lookup is evaluated by the compiler as well.
+static_assert(options.find_short('v') == options.find_long("verbose"));
+static_assert(options.find_long("verb") == nullptr);
+
+static void handle_option_event(const nuts_getopts_event& ev) {
+  // The options which was selected.
+  const nuts_getopts_option* option = ev.u.opt.option;
+
+  if (option->type == nuts_getopts_int64_value) {
+    std::printf("option: %c/%s, arg: %" PRId64 "\n",
+      option->sname, option->lname, ev.u.opt.typed.i64);
+  } else if (option->arg == nuts_getopts_required_argument) {
+    std::printf("option: %c/%s, arg: %s\n",
+      option->sname, option->lname, ev.u.opt.value);
+  } else {
+    std::printf("option: %c/%s, no-arg\n",
+      option->sname, option->lname);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // The state of the parser.
+  nuts_getopts_state state = {};
+
+  // The event the parser emits.
+  nuts_getopts_event ev = {};
+
+  // The options are looked up in the tables built by the compiler, there is
+  // nothing to set up.
+  while (nuts_getopts_lookup_parse(argc, argv, &nuts::getopts::lookup<options>, 0, &state, &ev) != -1) {
+    // Depending on the event-type call a related handler.
+    switch (ev.type) {
+      case nuts_getopts_tool_event:
+        std::printf("tool: %s\n", ev.u.tool);
+        break;
+      case nuts_getopts_option_event:
+        handle_option_event(ev);
+        break;
+      case nuts_getopts_argument_event:
+        std::printf("argument: %s\n", ev.u.arg);
+        break;
+      case nuts_getopts_error_event:
+        std::fprintf(stderr, "error: invalid argument %.*s\n",
+          ev.u.err.option_len, ev.u.err.option);
+        return 1;
+      case nuts_getopts_command_event:
+        // Not reported by nuts_getopts_lookup_parse().
+        break;
+    }
+  }
+
+  return 0;
+}
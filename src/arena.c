@@ -0,0 +1,164 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "private.h"
+
+// Alignment of all allocations, sufficient for any type used by the library.
+#define ALIGNMENT 16
+
+// Minimum size of a block requested from the growth callback.
+#define MIN_BLOCK_SIZE 4096
+
+/*
+ * Header of a block allocated by the growth callback. The blocks are linked,
+ * so they can be released in one go.
+ */
+struct nuts_getopts_arena_block {
+  struct nuts_getopts_arena_block* next;
+};
+
+#define BLOCK_HEADER_SIZE ((sizeof(struct nuts_getopts_arena_block) + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1))
+
+static void* bump(nuts_getopts_arena* arena, size_t size) {
+  uintptr_t start, aligned;
+  size_t needed;
+
+  if (arena->cur == NULL)
+    return NULL;
+
+  start = (uintptr_t)(arena->cur + arena->used);
+  aligned = (start + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1);
+  needed = aligned - start;
+
+  // Compares without adding, a huge size must not wrap around.
+  if (needed > arena->cur_size - arena->used || size > arena->cur_size - arena->used - needed)
+    return NULL;
+
+  needed += size;
+
+  arena->used += needed;
+
+  return (void*)aligned;
+}
+
+static int grow(nuts_getopts_arena* arena, size_t size) {
+  size_t block_size = (arena->cur_size > MIN_BLOCK_SIZE / 2) ? 2 * arena->cur_size : MIN_BLOCK_SIZE;
+  struct nuts_getopts_arena_block* block;
+
+  if (size > SIZE_MAX - BLOCK_HEADER_SIZE - ALIGNMENT)
+    return -1;
+
+  // Room for the header, the request and the alignment of the request.
+  if (block_size < BLOCK_HEADER_SIZE + size + ALIGNMENT)
+    block_size = BLOCK_HEADER_SIZE + size + ALIGNMENT;
+
+  if (arena->grow == NULL || (block = arena->grow(arena->ctx, NULL, block_size)) == NULL)
+    return -1;
+
+  block->next = arena->blocks;
+  arena->blocks = block;
+
+  arena->cur = (char*)block + BLOCK_HEADER_SIZE;
+  arena->cur_size = block_size - BLOCK_HEADER_SIZE;
+  arena->used = 0;
+
+  return 0;
+}
+
+void nuts_getopts_arena_init(nuts_getopts_arena* arena, void* buf, size_t size, void* (*grow)(void* ctx, void* block, size_t size), void* ctx) {
+  memset(arena, 0, sizeof(nuts_getopts_arena));
+
+  arena->buf = buf;
+  arena->size = size;
+  arena->grow = grow;
+  arena->ctx = ctx;
+
+  arena->cur = buf;
+  arena->cur_size = size;
+}
+
+void* nuts_getopts_arena_alloc(nuts_getopts_arena* arena, size_t size) {
+  void* ptr;
+
+  if ((ptr = bump(arena, size)) == NULL) {
+    if (grow(arena, size) != 0) {
+      errno = ENOMEM;
+      return NULL;
+    }
+
+    if ((ptr = bump(arena, size)) == NULL) {
+      errno = ENOMEM;
+      return NULL;
+    }
+  }
+
+  return memset(ptr, 0, size);
+}
+
+void nuts_getopts_arena_release(nuts_getopts_arena* arena) {
+  struct nuts_getopts_arena_block* block = arena->blocks;
+
+  while (block != NULL) {
+    struct nuts_getopts_arena_block* next = block->next;
+
+    arena->grow(arena->ctx, block, 0);
+    block = next;
+  }
+
+  arena->blocks = NULL;
+  arena->cur = arena->buf;
+  arena->cur_size = arena->size;
+  arena->used = 0;
+}
+
+void* nuts_getopts_arena_heap(void* ctx, void* block, size_t size) {
+  if (size == 0) {
+    free(block);
+    return NULL;
+  }
+
+  return malloc(size);
+}
+
+void* nuts_getopts_calloc(nuts_getopts_arena* arena, size_t size) {
+  void* ptr;
+
+  if (arena != NULL)
+    return nuts_getopts_arena_alloc(arena, size);
+
+  if ((ptr = calloc(1, size)) == NULL)
+    errno = ENOMEM;
+
+  return ptr;
+}
+
+void nuts_getopts_free(nuts_getopts_arena* arena, void* ptr) {
+  // Memory of an arena is only released with the arena.
+  if (arena == NULL)
+    free(ptr);
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "private.h"
+
+static struct nuts_getopts_command_entry* probe_command(struct nuts_getopts_command_entry* slots, uint32_t size, uint32_t hash, const char* name, int len) {
+  uint32_t idx = hash & (size - 1);
+
+  while (slots[idx].command != NULL) {
+    const struct nuts_getopts_command_entry* slot = &slots[idx];
+
+    if (slot->hash == hash && slot->len == len && memcmp(slot->command->name, name, len) == 0)
+      break;
+
+    idx = (idx + 1) & (size - 1);
+  }
+
+  return &slots[idx];
+}
+
+static int insert_command(nuts_getopts_commands* commands, const struct nuts_getopts_command* command) {
+  int len = strlen(command->name);
+  uint32_t hash = nuts_getopts_hash(command->name, len);
+  struct nuts_getopts_command_entry* slot = probe_command(commands->slots, commands->size, hash, command->name, len);
+
+  if (slot->command != NULL) {
+    errno = EEXIST;
+    return -1;
+  }
+
+  // A command with a resolver is compiled on first use. Sets errno on failure.
+  if (command->resolve == NULL && (slot->spec = nuts_getopts_compile_arena(command->groups, commands->arena)) == NULL)
+    return -1;
+
+  slot->hash = hash;
+  slot->len = len;
+  slot->command = command;
+
+  return 0;
+}
+
+struct nuts_getopts_command_entry* nuts_getopts_commands_find(const nuts_getopts_commands* commands, const char* name, int len) {
+  uint32_t hash = nuts_getopts_hash(name, len);
+  struct nuts_getopts_command_entry* slot = probe_command(commands->slots, commands->size, hash, name, len);
+
+  return (slot->command != NULL) ? slot : NULL;
+}
+
+const nuts_getopts_spec* nuts_getopts_command_resolve(const nuts_getopts_commands* commands, struct nuts_getopts_command_entry* entry) {
+  nuts_getopts_spec* spec = __atomic_load_n(&entry->spec, __ATOMIC_ACQUIRE);
+  nuts_getopts_spec* expected = NULL;
+  const struct nuts_getopts_option_group* groups;
+
+  if (spec != NULL)
+    return spec;
+
+  if ((groups = entry->command->resolve(entry->command)) == NULL)
+    return NULL;
+
+  if ((spec = nuts_getopts_compile_arena(groups, commands->arena)) == NULL)
+    return NULL;
+
+  // Another thread sharing the table could have compiled the command in the
+  // meantime, the first one wins.
+  if (!__atomic_compare_exchange_n(&entry->spec, &expected, spec, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    nuts_getopts_spec_free(spec);
+    spec = expected;
+  }
+
+  return spec;
+}
+
+nuts_getopts_commands* nuts_getopts_commands_compile(const struct nuts_getopts_command* command_list) {
+  return nuts_getopts_commands_compile_arena(command_list, NULL);
+}
+
+nuts_getopts_commands* nuts_getopts_commands_compile_arena(const struct nuts_getopts_command* command_list, nuts_getopts_arena* arena) {
+  nuts_getopts_commands* commands;
+  const struct nuts_getopts_command* command;
+  int n = 0;
+
+  for (command = command_list; command != NULL && command->name != NULL; command++)
+    n++;
+
+  if ((commands = nuts_getopts_calloc(arena, sizeof(nuts_getopts_commands))) == NULL)
+    return NULL;
+
+  commands->arena = arena;
+  commands->size = nuts_getopts_table_size(n);
+
+  if ((commands->slots = nuts_getopts_calloc(arena, commands->size * sizeof(struct nuts_getopts_command_entry))) == NULL) {
+    nuts_getopts_commands_free(commands);
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  for (command = command_list; n > 0; command++, n--) {
+    if (insert_command(commands, command) != 0) {
+      int err = errno;
+
+      nuts_getopts_commands_free(commands);
+      errno = err;
+      return NULL;
+    }
+  }
+
+  return commands;
+}
+
+void nuts_getopts_commands_free(nuts_getopts_commands* commands) {
+  if (commands != NULL) {
+    uint32_t i;
+
+    for (i = 0; commands->slots != NULL && i < commands->size; i++)
+      nuts_getopts_spec_free(commands->slots[i].spec);
+
+    nuts_getopts_free(commands->arena, commands->slots);
+    nuts_getopts_free(commands->arena, commands);
+  }
+}
+
+int nuts_getopts_command_parse(int argc, char* argv[], const nuts_getopts_spec* spec, const nuts_getopts_commands* commands, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  const struct resolver resolver = {
+    .spec = spec,
+    .local = (state->command != NULL) ? __atomic_load_n(&state->command->spec, __ATOMIC_ACQUIRE) : NULL,
+    .commands = commands
+  };
+
+  return nuts_getopts_parse(argc, argv, &resolver, flags, state, event);
+}
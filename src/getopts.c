@@ -25,31 +25,20 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "nuts-getopts.h"
+#include "private.h"
 
-#define _group_eof(entry) (((entry)->group == NULL) && ((entry)->list == NULL))
-#define _list_eof(entry) (((entry)->sname == 0) && ((entry)->lname == NULL))
-
-static inline int is_shortopt(const char* str) {
-  return (str[0] == '-') && (str[1] != '\0');
+static inline int is_shortopt(const struct token* token) {
+  return (token->len > 1) && (token->str[0] == '-');
 }
 
-static inline int is_longopt(const char* str) {
-  return (str[0] == '-') && (str[1] == '-') && (str[2] != '\0');
+static inline int is_longopt(const struct token* token) {
+  return (token->len > 2) && (token->str[0] == '-') && (token->str[1] == '-');
 }
 
 static inline int has_flag(int flags, int flag) {
   return ((flags & flag) > 0);
 }
 
-static void mk_option_event(struct nuts_getopts_event* event, const struct nuts_getopts_option* option, const char* value) {
-  if (event != NULL) {
-    event->type = nuts_getopts_option_event;
-    event->u.opt.option = option;
-    event->u.opt.value = value;
-  }
-}
-
 static void mk_error_event(struct nuts_getopts_event* event, nuts_getopts_error_type code, const char* option, int option_len) {
   if (event != NULL) {
     event->type = nuts_getopts_error_event;
@@ -59,12 +48,30 @@ static void mk_error_event(struct nuts_getopts_event* event, nuts_getopts_error_
   }
 }
 
-static const struct nuts_getopts_option* find_option(const struct nuts_getopts_option_group* options, const char sname, const char* lname, int lname_len) {
+static void mk_option_event(struct nuts_getopts_event* event, const struct token* token, const struct nuts_getopts_option* option, const char* value, int value_len) {
+  if (event != NULL) {
+    event->type = nuts_getopts_option_event;
+    event->u.opt.option = option;
+    event->u.opt.value = value;
+    event->len = value_len;
+
+    if (option->type != nuts_getopts_string_value) {
+      int err = nuts_getopts_convert(option->type, value, value_len, &event->u.opt.typed);
+
+      if (err != 0)
+        mk_error_event(event, err, token->str, token->len);
+    }
+  }
+}
+
+static const struct nuts_getopts_option* find_option(const struct nuts_getopts_option_group* options, const char sname, const char* lname, int lname_len, struct nuts_getopts_stats* stats) {
   const struct nuts_getopts_option_group* entry = options;
 
   while (!_group_eof(entry)) {
+    _stats_inc(stats, nodes);
+
     if (entry->group != NULL) {
-      const struct nuts_getopts_option* option = find_option(entry->group, sname, lname, lname_len);
+      const struct nuts_getopts_option* option = find_option(entry->group, sname, lname, lname_len, stats);
 
       if (option != NULL)
         return option;
@@ -74,9 +81,18 @@ static const struct nuts_getopts_option* find_option(const struct nuts_getopts_o
       const struct nuts_getopts_option* option = entry->list;
 
       while (!_list_eof(option)) {
-        if ((sname != 0 && option->sname == sname) ||
-            (lname != NULL && option->lname != NULL && strncmp(option->lname, lname, lname_len) == 0))
+        _stats_inc(stats, nodes);
+
+        if (sname != 0 && option->sname == sname)
           return option;
+
+        if (lname != NULL && option->lname != NULL) {
+          _stats_inc(stats, compares);
+
+          if (strncmp(option->lname, lname, lname_len) == 0)
+            return option;
+        }
+
         option++;
       }
     }
@@ -87,91 +103,270 @@ static const struct nuts_getopts_option* find_option(const struct nuts_getopts_o
   return NULL;
 }
 
-static int on_tool(int argc, char* argv[], nuts_getopts_state* state, struct nuts_getopts_event* event) {
+static inline const struct nuts_getopts_option* spec_find_long(const nuts_getopts_spec* spec, int flags, const char* lname, int lname_len) {
+  if (has_flag(flags, nuts_getopts_allow_abbreviations))
+    return nuts_getopts_spec_find_prefix(spec, lname, lname_len);
+  else
+    return nuts_getopts_spec_find_long(spec, lname, lname_len);
+}
+
+static inline const struct nuts_getopts_option* resolve_short(const struct resolver* resolver, char sname) {
+  const struct nuts_getopts_option* option = NULL;
+
+  _stats_inc(resolver->stats, lookups);
+
+  if (resolver->lookup != NULL)
+    return resolver->lookup->find_short(sname);
+
+  if (resolver->spec == NULL)
+    return find_option(resolver->groups, sname, NULL, 0, resolver->stats);
+
+  if (resolver->local != NULL)
+    option = nuts_getopts_spec_find_short(resolver->local, sname);
+
+  return (option != NULL) ? option : nuts_getopts_spec_find_short(resolver->spec, sname);
+}
+
+static inline const struct nuts_getopts_option* resolve_long(const struct resolver* resolver, int flags, const char* lname, int lname_len) {
+  const struct nuts_getopts_option* option = NULL;
+
+  _stats_inc(resolver->stats, lookups);
+
+  if (resolver->lookup != NULL)
+    return resolver->lookup->find_long(lname, lname_len);
+
+  if (resolver->spec == NULL)
+    return find_option(resolver->groups, 0, lname, lname_len, resolver->stats);
+
+  if (resolver->local != NULL)
+    option = spec_find_long(resolver->local, flags, lname, lname_len);
+
+  return (option != NULL) ? option : spec_find_long(resolver->spec, flags, lname, lname_len);
+}
+
+static int on_tool(const struct token* token, struct nuts_getopts_event* event) {
   if (event != NULL) {
-    const char* arg = argv[state->idx];
-    const char* pos = strrchr(arg, '/');
+    const char* pos = token->str + token->len;
+
+    while (pos > token->str && pos[-1] != '/')
+      pos--;
 
     event->type = nuts_getopts_tool_event;
-    event->u.tool =  (pos != NULL) ? pos + 1 : arg;
+    event->u.tool = pos;
+    event->len = token->str + token->len - pos;
   }
 
-  state->idx++;
-
   return 0;
 }
 
-static int on_shortopt(int argc, char* argv[], const struct nuts_getopts_option_group* options, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
-  const char* option = argv[state->idx];
+static int on_shortopt(const struct token* token, const struct resolver* resolver, int flags, struct nuts_getopts_event* event) {
+  const char* option = token->str;
   const char name = option[1];
-  const struct nuts_getopts_option* opt = find_option(options, name, NULL, 0);
+  const struct nuts_getopts_option* opt = resolve_short(resolver, name);
 
   int again = 0;
 
   if (opt == NULL) {
-    if (has_flag(flags, nuts_getopts_ignore_unknown_options))
+    if (has_flag(flags, nuts_getopts_ignore_unknown_options)) {
+      _stats_inc(resolver->stats, skipped);
       again = 1;
-    else
+    } else
       mk_error_event(event, nuts_getopts_invalid_option, option, 2);
   } else if (opt->arg == nuts_getopts_no_argument) {
-    if (strlen(option) == 2)
-      mk_option_event(event, opt, NULL);
+    if (token->len == 2)
+      mk_option_event(event, token, opt, NULL, 0);
     else
       mk_error_event(event, nuts_getopts_needless_value, option, 2);
   } else {
-    if (strlen(option) > 2)
-      mk_option_event(event, opt, option + 2);
+    if (token->len > 2)
+      mk_option_event(event, token, opt, option + 2, token->len - 2);
      else
       mk_error_event(event, nuts_getopts_missing_value, option, 2);
   }
 
-  state->idx++;
-
   return again;
 }
 
-static int on_longopt(int argc, char* argv[], const struct nuts_getopts_option_group* options, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
-  const char* option = argv[state->idx];
+static int on_longopt(const struct token* token, const struct resolver* resolver, int flags, struct nuts_getopts_event* event) {
+  const char* option = token->str;
   const char* name = option + 2;
-  const char* eq = strchr(name, '=');
-  int name_len = (eq != NULL) ? eq - name : strlen(name);
+  int name_len = ((token->eq >= 0) ? token->eq : token->len) - 2;
 
-  const struct nuts_getopts_option* opt = find_option(options, 0, name, name_len);
+  const struct nuts_getopts_option* opt = resolve_long(resolver, flags, name, name_len);
   int again = 0;
 
-  if (opt == NULL) {
-    if (has_flag(flags, nuts_getopts_ignore_unknown_options))
+  if (opt == &nuts_getopts_ambiguous) {
+    mk_error_event(event, nuts_getopts_ambiguous_option, option, name_len + 2);
+  } else if (opt == NULL) {
+    if (has_flag(flags, nuts_getopts_ignore_unknown_options)) {
+      _stats_inc(resolver->stats, skipped);
       again = 1;
-    else
+    } else
       mk_error_event(event, nuts_getopts_invalid_option, option, name_len + 2);
   } else if (opt->arg == nuts_getopts_no_argument) {
-    if (eq == NULL)
-      mk_option_event(event, opt, NULL);
+    if (token->eq < 0)
+      mk_option_event(event, token, opt, NULL, 0);
      else
       mk_error_event(event, nuts_getopts_needless_value, option, name_len + 2);
   } else {
-    if (eq != NULL)
-      mk_option_event(event, opt, eq + 1);
+    if (token->eq >= 0)
+      mk_option_event(event, token, opt, option + token->eq + 1, token->len - token->eq - 1);
     else
       mk_error_event(event, nuts_getopts_missing_value, option, name_len + 2);
   }
 
-  state->idx++;
-
   return again;
 }
 
-static int on_argument(int argc, char* argv[], nuts_getopts_state* state, struct nuts_getopts_event* event) {
+static int on_argument(const struct token* token, struct nuts_getopts_event* event) {
   if (event != NULL) {
     event->type = nuts_getopts_argument_event;
-    event->u.arg = argv[state->idx];
+    event->u.arg = token->str;
+    event->len = token->len;
   }
 
-  state->idx++;
+  return 0;
+}
+
+static inline int skip_option(int flags, const struct nuts_getopts_event* event) {
+  // Errors are never filtered.
+  return has_flag(flags, nuts_getopts_skip_options) && event != NULL && event->type == nuts_getopts_option_event;
+}
+
+int nuts_getopts_on_token(const struct token* token, int is_tool, const struct resolver* resolver, int flags, struct nuts_getopts_event* event) {
+  // Filtered events are consumed here, like ignored options. Tools and
+  // arguments are not even created.
+  if (is_tool)
+    return has_flag(flags, nuts_getopts_skip_tool) || on_tool(token, event);
+  else if (is_longopt(token))
+    return on_longopt(token, resolver, flags, event) || skip_option(flags, event);
+  else if (is_shortopt(token))
+    return on_shortopt(token, resolver, flags, event) || skip_option(flags, event);
+  else
+    return has_flag(flags, nuts_getopts_skip_arguments) || on_argument(token, event);
+}
+
+static int on_response_file(const struct token* token, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  if (nuts_getopts_response_push(state, token) != 0) {
+    mk_error_event(event, nuts_getopts_invalid_response_file, token->str, token->len);
+    return 0;
+  }
+
+  // Continue with the first token of the response file.
+  return 1;
+}
+
+static int on_command(const struct token* token, const struct resolver* resolver, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  struct nuts_getopts_command_entry* entry = nuts_getopts_commands_find(resolver->commands, token->str, token->len);
+
+  // Only the first argument selects a command.
+  state->command_done = 1;
+
+  if (entry == NULL)
+    return has_flag(flags, nuts_getopts_skip_arguments) || on_argument(token, event);
+
+  if (nuts_getopts_command_resolve(resolver->commands, entry) == NULL) {
+    mk_error_event(event, nuts_getopts_invalid_command, token->str, token->len);
+    return 0;
+  }
+
+  state->command = entry;
+
+  if (event != NULL) {
+    event->type = nuts_getopts_command_event;
+    event->u.cmd = entry->command;
+    event->len = token->len;
+  }
+
+  return 0;
+}
+
+static inline int at_end(int argc, const nuts_getopts_state* state) {
+  return (state->idx >= argc) && (state->response == NULL);
+}
+
+static inline int parse_next(int argc, char* argv[], const struct resolver* resolver, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  struct token token;
+  int is_tool = 0;
+
+  _stats_inc(resolver->stats, tokens);
+
+  if (state->response != NULL) {
+    if (nuts_getopts_response_next(state, &token) != 0)
+      return 1;
+  } else {
+    token.str = argv[state->idx];
+
+    // Length and position of the assignment operator are determined in a
+    // single pass over the argument.
+    nuts_getopts_scan(&token);
+
+    is_tool = (state->idx++ == 0);
+  }
+
+  if (has_flag(flags, nuts_getopts_response_files) && !is_tool && token.len > 1 && token.str[0] == '@')
+    return on_response_file(&token, state, event);
+
+  if (resolver->commands != NULL && !state->command_done && !is_tool && !is_shortopt(&token))
+    return on_command(&token, resolver, flags, state, event);
+
+  return nuts_getopts_on_token(&token, is_tool, resolver, flags, event);
+}
+
+static int parse_loop(int argc, char* argv[], const struct resolver* resolver, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  int again = 1;
+
+  while (again) {
+    if (at_end(argc, state))
+      return -1;
+
+    again = parse_next(argc, argv, resolver, flags, state, event);
+  }
 
   return 0;
 }
 
+#ifdef NUTS_GETOPTS_STATS
+static int parse_traced(int argc, char* argv[], const struct resolver* resolver, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  struct nuts_getopts_stats* stats = state->stats;
+  struct resolver traced = *resolver;
+  uint64_t start = nuts_getopts_cycles(), cycles;
+  int result;
+
+  traced.stats = stats;
+  result = parse_loop(argc, argv, &traced, flags, state, event);
+  cycles = nuts_getopts_cycles() - start;
+
+  if (stats != NULL) {
+    stats->invocations++;
+    stats->cycles += cycles;
+
+    if (cycles > stats->max_cycles)
+      stats->max_cycles = cycles;
+    if (result == 0 && event->type == nuts_getopts_error_event)
+      stats->errors[event->u.err.type]++;
+  }
+
+  if (result == 0 && state->trace != NULL)
+    state->trace(event, stats, cycles, state->trace_ctx);
+
+  return result;
+}
+#endif
+
+int nuts_getopts_parse(int argc, char* argv[], const struct resolver* resolver, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  memset(event, 0, sizeof(struct nuts_getopts_event));
+
+#ifdef NUTS_GETOPTS_STATS
+  // An instrumented build only pays for the instrumentation, if it is
+  // attached to the state.
+  if (state->stats != NULL || state->trace != NULL)
+    return parse_traced(argc, argv, resolver, flags, state, event);
+#endif
+
+  return parse_loop(argc, argv, resolver, flags, state, event);
+}
+
 int nuts_getopts(int argc, char* argv[], const struct nuts_getopts_option* options, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
   const struct nuts_getopts_option_group all_options[] = {
     { .group = NULL, .list = options },
@@ -182,23 +377,52 @@ int nuts_getopts(int argc, char* argv[], const struct nuts_getopts_option* optio
 }
 
 int nuts_getopts_group(int argc, char* argv[], const struct nuts_getopts_option_group* options, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
-  memset(event, 0, sizeof(struct nuts_getopts_event));
+  const struct resolver resolver = { .groups = options };
 
-  int again = 1;
+  return nuts_getopts_parse(argc, argv, &resolver, flags, state, event);
+}
 
-  while (again) {
-    if (state->idx >= argc)
-      return -1;
+int nuts_getopts_spec_parse(int argc, char* argv[], const nuts_getopts_spec* spec, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  const struct resolver resolver = { .spec = spec };
 
-    if (state->idx == 0)
-      again = on_tool(argc, argv, state, event);
-    else if (is_longopt(argv[state->idx]))
-      again = on_longopt(argc, argv, options, flags, state, event);
-    else if (is_shortopt(argv[state->idx]))
-      again = on_shortopt(argc, argv, options, flags, state, event);
-    else
-      again = on_argument(argc, argv, state, event);
+  return nuts_getopts_parse(argc, argv, &resolver, flags, state, event);
+}
+
+int nuts_getopts_lookup_parse(int argc, char* argv[], const struct nuts_getopts_lookup* lookup, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  const struct resolver resolver = { .lookup = lookup };
+
+  return nuts_getopts_parse(argc, argv, &resolver, flags, state, event);
+}
+
+int nuts_getopts_parse_all(int argc, char* argv[], const nuts_getopts_spec* spec, int flags, nuts_getopts_state* state, struct nuts_getopts_event* events, int size, int* count) {
+  const struct resolver resolver = { .spec = spec };
+  int n = 0;
+
+  while (!at_end(argc, state)) {
+    if (n == size) {
+      *count = n;
+      return 0;
+    }
+
+    // An ignored option leaves the slot untouched, it is reused for the next
+    // argument.
+    if (parse_next(argc, argv, &resolver, flags, state, &events[n]) == 0)
+      n++;
   }
 
-  return 0;
+  *count = n;
+
+  return -1;
+}
+
+int nuts_getopts_parse_range(int argc, char* argv[], const struct resolver* resolver, int flags, int begin, int end, struct nuts_getopts_event* events) {
+  nuts_getopts_state state = { .idx = begin };
+  int n = 0;
+
+  while (state.idx < end) {
+    if (parse_next(argc, argv, resolver, flags, &state, &events[n]) == 0)
+      n++;
+  }
+
+  return n;
 }
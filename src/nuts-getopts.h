@@ -25,10 +25,21 @@
 #ifndef NUTS_GETOPTS_H
 #define NUTS_GETOPTS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * Linkage of the public functions. The single header nuts-getopts-single.h
+ * turns them into static inline functions.
+ */
+#ifndef NUTS_GETOPTS_API
+#define NUTS_GETOPTS_API
+#endif
+
 /**
  * A zero-copy command line parser.
  *
@@ -169,10 +180,252 @@ extern "C" {
  * nuts_getopts() invocation. The parser will re-initialize its content with
  * each invation of nuts_getopts().
  *
+ * ### Response files
+ * @anchor response_files
+ *
+ * If the #nuts_getopts_response_files flag is passed to the parser, a command
+ * line argument starting with `@` names a response file. The parser reads the
+ * command line arguments from the file instead. The arguments in the file are
+ * separated by whitespace, quoting is not supported. A response file can
+ * reference further response files.
+ *
+ * The file is mapped into memory and parsed in place, when the parser reaches
+ * it. The strings reported by the events point directly into the mapping and
+ * are *not* NUL-terminated, use nuts_getopts_event#len resp.
+ * nuts_getopts_event#u.err.option_len to get their length. The mappings are
+ * kept until you call nuts_getopts_state_release().
+ *
+ * @code{.sh}
+ * # args.txt contains "--verbose=1 makeitso"
+ * sample-tool @args.txt
+ * @endcode
+ *
+ * ### Streams
+ *
+ * Besides `argc`/`argv` the parser can read the command line arguments from
+ * a nuts_getopts_stream, e.g. the output of `find -print0`. The arguments are
+ * separated by a delimiter (typically `\0` or `\n`). The stream reads its
+ * input into a fixed buffer supplied by the caller, which is refilled as
+ * parsing goes on. So the memory usage is bounded by the size of the buffer,
+ * no matter how many arguments are read.
+ *
+ * @code
+ * char buf[65536];
+ * nuts_getopts_stream stream;
+ *
+ * nuts_getopts_stream_init_fd(&stream, STDIN_FILENO, '\0', buf, sizeof(buf));
+ *
+ * while (nuts_getopts_stream_group(&stream, groups, 0, &ev) == 0) {
+ *   ...
+ * }
+ * @endcode
+ *
+ * A stream does not report a #nuts_getopts_tool_event, each argument is
+ * either an option or an argument. Empty arguments are skipped.
+ *
+ * ### Command line strings
+ *
+ * A command line received as a single string (e.g. a line read by a command
+ * server) can be split into an argument vector with nuts_getopts_split(). The
+ * string is split like a POSIX shell does: words are separated by blanks,
+ * single and double quotes and backslashes escape special characters. The
+ * words are unquoted in place, no memory is allocated.
+ *
+ * @code
+ * char line[] = "sample-tool --name='John Doe' \"a b\"";
+ * char* args[64];
+ * int n = nuts_getopts_split(line, args, 64);
+ *
+ * // args = { "sample-tool", "--name=John Doe", "a b", NULL }
+ * while (nuts_getopts(n, args, options, 0, &state, &ev) == 0) {
+ *   ...
+ * }
+ * @endcode
+ *
+ * ## Compiled specs
+ *
+ * nuts_getopts_group() traverses the option tree for every option it finds on
+ * the command line. For large option trees and long command lines you can
+ * compile the tree once with nuts_getopts_compile(). The resulting
+ * nuts_getopts_spec holds an index over all short and long names, which is
+ * used by nuts_getopts_spec_parse() to look up an option in constant time.
+ *
+ * @code
+ * nuts_getopts_spec* spec = nuts_getopts_compile(all_options);
+ *
+ * while (nuts_getopts_spec_parse(argc, argv, spec, 0, &state, &ev) == 0) {
+ *   ...
+ * }
+ *
+ * nuts_getopts_spec_free(spec);
+ * @endcode
+ *
+ * ### Generated parsers
+ * @anchor generated_parsers
+ *
+ * If the options of a tool are known at build time, even the compilation can
+ * be moved out of the tool. The `nuts-getopts-gen` code generator reads a
+ * declarative spec and emits a C source with the nuts_getopts_option table, a
+ * `switch` statement for the short names and a minimal perfect hash for the
+ * long names. The CMake function `nuts_getopts_generate(<target> <spec>)`
+ * runs the generator and adds the source to the target.
+ *
+ * @code{.sh}
+ * # tool.spec: <short> <long> <argument> [<type>]
+ * v verbose required int64
+ * - quiet   none
+ * @endcode
+ *
+ * The source defines `tool_options` and `tool_lookup` (named after the spec
+ * file) and is used with nuts_getopts_lookup_parse(). There is no setup at
+ * runtime.
+ *
+ * @code
+ * #include "tool.h"
+ *
+ * while (nuts_getopts_lookup_parse(argc, argv, &tool_lookup, 0, &state, &ev) == 0) {
+ *   ...
+ * }
+ * @endcode
+ *
+ * ### C++
+ *
+ * A C++17 tool does not need the code generator. The option table is
+ * declared as a `constexpr` nuts::getopts::spec (see `nuts-getopts.hpp`),
+ * which the compiler checks for duplicate names and indexes. The resulting
+ * nuts::getopts::lookup is passed to nuts_getopts_lookup_parse().
+ *
+ * ### Shared specs
+ *
+ * A compiled spec is never modified by the parser, so any number of threads
+ * can parse with the same spec concurrently (each with its own
+ * nuts_getopts_state). To replace the spec at runtime, e.g. when a server
+ * reloads its configuration, wrap it into a nuts_getopts_shared. Readers
+ * enclose each parser run with nuts_getopts_shared_acquire() and
+ * nuts_getopts_shared_release(), which never block. A writer publishes a new
+ * spec with nuts_getopts_shared_swap(), which waits until no reader uses the
+ * old spec anymore (similar to RCU).
+ *
+ * @code
+ * // Worker thread
+ * int ticket;
+ * const nuts_getopts_spec* spec = nuts_getopts_shared_acquire(shared, &ticket);
+ *
+ * while (nuts_getopts_spec_parse(argc, argv, spec, 0, &state, &ev) == 0) {
+ *   ...
+ * }
+ *
+ * nuts_getopts_shared_release(shared, ticket);
+ *
+ * // Reloading thread
+ * nuts_getopts_spec_free(nuts_getopts_shared_swap(shared, nuts_getopts_compile(groups)));
+ * @endcode
+ *
+ * ## Commands
+ *
+ * Tools like `git` select an action by their first argument, each action
+ * having its own set of options. Define the actions in an array of
+ * nuts_getopts_command entries and compile them with
+ * nuts_getopts_commands_compile(). nuts_getopts_command_parse() looks up the
+ * first argument in a hash table of the command names. If it names a command,
+ * a #nuts_getopts_command_event is emitted and the options of the command
+ * become active immediately, in addition to the global options. Thus a single
+ * pass over the command line is sufficient.
+ *
+ * For tools with lots of commands the options of a command can be resolved
+ * on demand by a nuts_getopts_command#resolve function. Only the options of
+ * the selected command are compiled then, and the result is cached for
+ * further parser runs with the same table.
+ *
+ * @code
+ * const struct nuts_getopts_command commands[] = {
+ *   { "one", one_options },
+ *   { "two", two_options },
+ *   { NULL }
+ * };
+ * nuts_getopts_spec* spec = nuts_getopts_compile(global_options);
+ * nuts_getopts_commands* cmds = nuts_getopts_commands_compile(commands);
+ *
+ * while (nuts_getopts_command_parse(argc, argv, spec, cmds, 0, &state, &ev) == 0) {
+ *   ...
+ * }
+ * @endcode
+ *
+ * ## Suggestions
+ *
+ * For a #nuts_getopts_invalid_option error of a long option (`--name`) a tool
+ * can suggest options with a similar long name ("did you mean --verbose?").
+ * Build the index once with nuts_getopts_suggestions_compile(),
+ * nuts_getopts_suggest() returns the options closest to the misspelled name
+ * by edit distance. The index is a BK-tree, so only a fraction of the names is
+ * compared, even for specs with thousands of options.
+ *
+ * @code
+ * nuts_getopts_suggestions* suggestions = nuts_getopts_suggestions_compile(spec);
+ * const struct nuts_getopts_option* options[3];
+ * int n = nuts_getopts_suggest(suggestions, ev.u.err.option, ev.u.err.option_len, 2, options, 3);
+ *
+ * for (int i = 0; i < n; i++)
+ *   fprintf(stderr, "did you mean --%s?\n", options[i]->lname);
+ * @endcode
+ *
+ * ## Instrumentation
+ *
+ * If the library is built with the CMake option `NUTS_GETOPTS_STATS` (resp.
+ * the single header is included with `NUTS_GETOPTS_STATS` defined), the
+ * parser counts what it is doing: options looked up, nodes of the option tree
+ * visited, name comparisons, unknown options skipped, errors by type and the
+ * time spent in the parser. The counters are attached to a parser state with
+ * nuts_getopts_state_trace(), optionally with a callback invoked for each
+ * event. Without the option the instrumentation is compiled out.
+ *
+ * @code
+ * struct nuts_getopts_stats stats = { 0 };
+ *
+ * nuts_getopts_state_trace(&state, &stats, NULL, NULL);
+ *
+ * while (nuts_getopts_group(argc, argv, groups, 0, &state, &ev) == 0) {
+ *   ...
+ * }
+ *
+ * printf("%lu lookups, %lu nodes\n", stats.lookups, stats.nodes);
+ * @endcode
+ *
+ * Only the parsers reporting one event per invocation are instrumented, i.e.
+ * not nuts_getopts_parse_all(), nuts_getopts_parse_parallel() and the stream
+ * parsers.
+ *
+ * ## Single-header build
+ *
+ * The build creates the single header `nuts-getopts-single.h`, which contains
+ * the public interface and the complete implementation. If the header is
+ * included with `NUTS_GETOPTS_IMPLEMENTATION` defined, the implementation is
+ * compiled into the including translation unit and all functions are
+ * `static inline`. Thus no library is linked and the compiler is able to
+ * inline the parser into the caller, e.g. to specialize it for a constant
+ * option array and flags. Without `NUTS_GETOPTS_IMPLEMENTATION` the header
+ * behaves like `nuts-getopts.h`.
+ *
+ * @code
+ * // Must be included first, the implementation needs POSIX.
+ * #define NUTS_GETOPTS_IMPLEMENTATION
+ * #include "nuts-getopts-single.h"
+ * @endcode
+ *
+ * The implementation is C only, it requires the threads library
+ * (`-pthread`).
+ *
  * ## Example
  *
  * * {@link getopts.c} is an example of how to use nuts_getopts().
  * * {@link getopts_group.c} is an example of how to use nuts_getopts_group().
+ * * {@link getopts_command.c} is an example of how to use
+ *   nuts_getopts_command_parse().
+ * * {@link getopts_generated.c} is an example of a generated parser.
+ * * {@link getopts_spec.cpp} is an example of an option table compiled by the
+ *   C++ compiler.
+ * * {@link getopts_range.cpp} is an example of how to iterate over the events
+ *   in C++.
  */
 
 /**
@@ -200,7 +453,14 @@ typedef enum {
   /**
    * An error occured.
    */
-  nuts_getopts_error_event
+  nuts_getopts_error_event,
+
+  /**
+   * A command was detected.
+   *
+   * Only reported by nuts_getopts_command_parse().
+   */
+  nuts_getopts_command_event
 } nuts_getopts_event_type;
 
 /**
@@ -215,9 +475,72 @@ typedef enum {
   /**
    * The option requires an argument.
    */
-  nuts_getopts_required_argument
+  nuts_getopts_required_argument,
+
+  /**
+   * The option requires an argument and can be repeated.
+   *
+   * The parser reports each occurrence like an option with
+   * #nuts_getopts_required_argument. A nuts_getopts_result collects the
+   * values of all occurrences into a contiguous array, see
+   * nuts_getopts_values().
+   */
+  nuts_getopts_multi_argument
 } nuts_getopts_argument_type;
 
+/**
+ * Value types supported by an #nuts_getopts_option.
+ *
+ * The parser converts the option-argument into the given type and stores the
+ * result in {@link nuts_getopts_event#u u.opt.typed}. The conversion does not
+ * depend on the locale.
+ */
+typedef enum {
+  /**
+   * The option-argument is not converted (the default).
+   */
+  nuts_getopts_string_value,
+
+  /**
+   * A signed decimal (or `0x` prefixed hexadecimal) integer, stored in
+   * nuts_getopts_typed#i64.
+   */
+  nuts_getopts_int64_value,
+
+  /**
+   * An unsigned decimal (or `0x` prefixed hexadecimal) integer, stored in
+   * nuts_getopts_typed#u64.
+   */
+  nuts_getopts_uint64_value,
+
+  /**
+   * A floating point number (`-1.5`, `2e10`), stored in
+   * nuts_getopts_typed#f64. The value is rounded correctly like by
+   * `strtod(3)`, but a decimal point is expected regardless of the locale.
+   */
+  nuts_getopts_double_value,
+
+  /**
+   * A boolean value (`1`/`0`, `true`/`false`, `yes`/`no`, `on`/`off`),
+   * stored in nuts_getopts_typed#b. An option without argument of this type
+   * reports `1`.
+   */
+  nuts_getopts_bool_value,
+
+  /**
+   * A size in bytes with an optional binary suffix (`4096`, `4K`, `4KiB`,
+   * `2G`, ...), stored in nuts_getopts_typed#u64.
+   */
+  nuts_getopts_size_value,
+
+  /**
+   * A duration in nanoseconds (`500ms`, `1h30m`, ...), stored in
+   * nuts_getopts_typed#u64. Supported units are `ns`, `us`, `ms`, `s`, `m`,
+   * `h` and `d`. A plain number is taken as seconds.
+   */
+  nuts_getopts_duration_value
+} nuts_getopts_value_type;
+
 /**
  * Error types supported by _nuts-getopts_.
  *
@@ -240,9 +563,59 @@ typedef enum {
    * The option was configured not to have an argument; an option-argument was
    * detected.
    */
-  nuts_getopts_needless_value
+  nuts_getopts_needless_value,
+
+  /**
+   * A response file (`@path`) cannot be read or response files are nested
+   * too deeply.
+   */
+  nuts_getopts_invalid_response_file,
+
+  /**
+   * An argument read from a nuts_getopts_stream does not fit into the buffer
+   * of the stream. The error reports the beginning of the argument, the
+   * argument is skipped.
+   */
+  nuts_getopts_argument_too_long,
+
+  /**
+   * An abbreviated long option matches several options.
+   *
+   * Only reported with the #nuts_getopts_allow_abbreviations flag.
+   */
+  nuts_getopts_ambiguous_option,
+
+  /**
+   * The option-argument cannot be converted into the
+   * {@link nuts_getopts_option#type type} of the option.
+   */
+  nuts_getopts_invalid_value,
+
+  /**
+   * The option-argument exceeds the range of the
+   * {@link nuts_getopts_option#type type} of the option.
+   */
+  nuts_getopts_value_out_of_range,
+
+  /**
+   * The options of the command cannot be resolved, see
+   * nuts_getopts_command#resolve.
+   */
+  nuts_getopts_invalid_command,
+
+  /**
+   * Memory allocation failed.
+   *
+   * Only reported by nuts_getopts_result_parse(), the option is `NULL`.
+   */
+  nuts_getopts_out_of_memory
 } nuts_getopts_error_type;
 
+/**
+ * Number of error types, the size of nuts_getopts_stats#errors.
+ */
+#define NUTS_GETOPTS_ERROR_TYPES (nuts_getopts_out_of_memory + 1)
+
 /**
  * Flags which can be passed to nuts_getopts() resp. nuts_getopts_group().
  */
@@ -254,7 +627,52 @@ typedef enum {
    * An option is undefined when it is not defined as an nuts_getopts_option
    * entry.
    */
-  nuts_getopts_ignore_unknown_options = 0x01
+  nuts_getopts_ignore_unknown_options = 0x01,
+
+  /**
+   * Expand response files.
+   *
+   * A command line argument `@path` is replaced by the content of the file
+   * `path`. See \ref response_files "Response files" for details.
+   */
+  nuts_getopts_response_files = 0x02,
+
+  /**
+   * Accept abbreviated long options.
+   *
+   * A long option can be abbreviated, as long as the abbreviation is unique,
+   * e.g. `--verb` selects `--verbose`. An abbreviation matching several
+   * options is reported as #nuts_getopts_ambiguous_option. An exact match
+   * always wins over an abbreviation.
+   *
+   * The flag is only supported by parsers using a compiled
+   * nuts_getopts_spec.
+   */
+  nuts_getopts_allow_abbreviations = 0x04,
+
+  /**
+   * Don't report #nuts_getopts_tool_event events.
+   *
+   * Like the skip-flags below, the event is consumed inside the parser and
+   * the parser continues with the next command line argument. This is
+   * cheaper than returning every event and discarding it by checking
+   * nuts_getopts_event#type.
+   */
+  nuts_getopts_skip_tool = 0x08,
+
+  /**
+   * Don't report #nuts_getopts_option_event events.
+   *
+   * The options are still checked, a #nuts_getopts_error_event is reported
+   * for an invalid option, unless #nuts_getopts_ignore_unknown_options is
+   * set.
+   */
+  nuts_getopts_skip_options = 0x10,
+
+  /**
+   * Don't report #nuts_getopts_argument_event events.
+   */
+  nuts_getopts_skip_arguments = 0x20
 } nuts_getopts_flags;
 
 /**
@@ -276,7 +694,7 @@ struct nuts_getopts_option {
    *
    * It set to `NULL` the option does not define a long name.
    */
-  char* lname;
+  const char* lname;
 
   /**
    * The argument of the option.
@@ -284,6 +702,43 @@ struct nuts_getopts_option {
    * This flag specifies whether the option has an argument or not.
    */
   nuts_getopts_argument_type arg;
+
+  /**
+   * The type of the option-argument.
+   *
+   * If set, the parser converts the argument into the given type. Defaults to
+   * #nuts_getopts_string_value, when omitted in an initializer.
+   */
+  nuts_getopts_value_type type;
+};
+
+/**
+ * A converted option-argument.
+ *
+ * Depending on the {@link nuts_getopts_option#type type} of the option one of
+ * the members is filled.
+ */
+union nuts_getopts_typed {
+  /**
+   * For #nuts_getopts_int64_value.
+   */
+  int64_t i64;
+
+  /**
+   * For #nuts_getopts_uint64_value, #nuts_getopts_size_value and
+   * #nuts_getopts_duration_value.
+   */
+  uint64_t u64;
+
+  /**
+   * For #nuts_getopts_double_value.
+   */
+  double f64;
+
+  /**
+   * For #nuts_getopts_bool_value.
+   */
+  int b;
 };
 
 /**
@@ -307,6 +762,50 @@ struct nuts_getopts_option_group {
   const struct nuts_getopts_option* list;
 };
 
+/**
+ * Defines a command.
+ *
+ * A command is selected by the first argument on the command line and
+ * activates its own options.
+ */
+struct nuts_getopts_command {
+  /**
+   * The name of the command.
+   *
+   * The last entry of a command array has a `NULL` name.
+   */
+  const char* name;
+
+  /**
+   * The options, which are only valid after the command.
+   *
+   * The last entry of the array must contain only zeros. `NULL` is a
+   * convenient value for a command without options.
+   */
+  const struct nuts_getopts_option_group* groups;
+
+  /**
+   * Resolves the options of the command on demand.
+   *
+   * If set, #groups is ignored. The function is called when the command is
+   * selected on the command line for the first time and returns the options
+   * of the command (the last entry of the array must contain only zeros).
+   * The options are compiled and cached in the nuts_getopts_commands table,
+   * further selections of the command neither call the function nor compile
+   * the options again. The returned options must be valid as long as the
+   * table is in use.
+   *
+   * If the function returns `NULL`, the parser reports a
+   * #nuts_getopts_invalid_command error.
+   */
+  const struct nuts_getopts_option_group* (*resolve)(const struct nuts_getopts_command* command);
+
+  /**
+   * User data, e.g. for the #resolve function. Not used by the parser.
+   */
+  void* ctx;
+};
+
 /**
  * An event reported by the parser.
  */
@@ -352,6 +851,14 @@ struct nuts_getopts_event {
        * always `NULL`.
        */
       const char* value;
+
+      /**
+       * The converted argument of the option.
+       *
+       * Filled, if the {@link nuts_getopts_option#type type} of the option
+       * is not #nuts_getopts_string_value.
+       */
+      union nuts_getopts_typed typed;
     } opt;
 
     /**
@@ -360,6 +867,12 @@ struct nuts_getopts_event {
      */
     const char* arg;
 
+    /**
+     * For a #nuts_getopts_command_event event: a link to the command, which
+     * was passed to nuts_getopts_commands_compile().
+     */
+    const struct nuts_getopts_command* cmd;
+
     /**
      * For a #nuts_getopts_error_event event: encodes the error.
      */
@@ -371,6 +884,9 @@ struct nuts_getopts_event {
 
       /**
        * The option, where the error occured.
+       *
+       * For #nuts_getopts_invalid_value and #nuts_getopts_value_out_of_range
+       * the complete command line argument including the value is reported.
        */
       const char* option;
 
@@ -380,59 +896,248 @@ struct nuts_getopts_event {
       int option_len;
     } err;
   } u;
+
+  /**
+   * The length of the string reported by the event.
+   *
+   * Contains the length of {@link nuts_getopts_event#u u.tool},
+   * {@link nuts_getopts_event#u u.arg}, the command name resp.
+   * {@link nuts_getopts_event#u u.opt.value}, so you don't need to call
+   * `strlen(3)` on it. The length is `0` for an option without a value. For
+   * an error event the length is stored in
+   * {@link nuts_getopts_event#u u.err.option_len}.
+   */
+  int len;
 };
 
 /**
- * The state of the parser.
+ * A bump allocator for the memory allocated by the library.
  *
- * The state of the parser. An instance of this type has to filled with zeroes
- * before the first invocation of nuts_getopts(). Don't touch the state
- * afterwards, nuts_getopts() stores its internal state in the variable.
+ * The arena hands out memory from a buffer supplied by the caller. If the
+ * buffer is exhausted, further blocks are requested from an optional growth
+ * callback. All memory is released at once by nuts_getopts_arena_release(),
+ * there is no need to free single allocations.
  *
- * The members of the type is hidden for the public interface, there is no need
- * to modify the variable directly.
+ * Compiled specs, command tables, result stores and the parser state (see
+ * nuts_getopts_state_init()) can be placed into an arena. Without an arena
+ * they are allocated from the heap. An arena is not thread-safe.
+ *
+ * @code
+ * char buf[16384];
+ * nuts_getopts_arena arena;
+ *
+ * nuts_getopts_arena_init(&arena, buf, sizeof(buf), nuts_getopts_arena_heap, NULL);
+ * spec = nuts_getopts_compile_arena(groups, &arena);
+ * ...
+ * nuts_getopts_arena_release(&arena);
+ * @endcode
+ *
+ * The members of the type are hidden for the public interface, there is no
+ * need to modify the variable directly.
  */
 typedef struct {
 /** @cond SKIP_DOC */
-  int idx;
+  char* buf;
+  size_t size;
+  char* cur;
+  size_t cur_size;
+  size_t used;
+  void* (*grow)(void* ctx, void* block, size_t size);
+  void* ctx;
+  struct nuts_getopts_arena_block* blocks;
 /** @endcond */
-} nuts_getopts_state;
+} nuts_getopts_arena;
 
 /**
- * Calls the _nuts-getopts_ parser.
- *
- * Parses the command line arguments `argc`/`argv` and generates an event placed in the `event` argument.
- * The event contains the option, argument, ... which was detected.
+ * Counters of an instrumented parser, see nuts_getopts_state_trace().
  *
- * @param argc Number of arguments in `argv`.
- * @param argv Command line arguments to be parsed.
- * @param options Array with options, which can be detected by the parser. The
- *                last entry of the array must contain only zeros. Passing
- *                `NULL` to `options` is a convenient value for an empty array
- *                (no options).
- * @param flags Flags, which controls the parser. Multiple flags are OR'ed
- *              together. See #nuts_getopts_flags for a list of supported
- *              flags. If no flags should be specified, `0` must be specified
- *              here.
- * @param state The state of the parser. The nuts_getopts_state instance has to
- *              filled with zeroes before the first invocation of
- *              nuts_getopts(). Don't touch the state afterwards,
- *              nuts_getopts() stores its internal state in the variable.
- * @param event The parser stores the next event in this variable. You only
- *              need to read the variable after a successful nuts_getopts()
- *              invocation. The parser will re-initialize its content with each
- *              invation of nuts_getopts().
- * @return The function returns
- *         * `0`: Another event was generated and placed into the `event`
- *                argument. Another nuts_getopts() invocation is required to
- *                parse the next component.
- *         * `-1`: All command line arguments were parsed. No further
- *                 nuts_getopts() invocations are required.
+ * The counters are accumulated over all invocations of the parser with the
+ * state the counters are attached to.
  */
-int nuts_getopts(int argc, char* argv[], const struct nuts_getopts_option* options, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+struct nuts_getopts_stats {
+  /**
+   * Number of parser invocations.
+   */
+  unsigned long invocations;
 
-/**
- * Calls the _nuts-getopts_ parser (with grouped options).
+  /**
+   * Number of command line arguments processed.
+   */
+  unsigned long tokens;
+
+  /**
+   * Number of option lookups by short or long name.
+   */
+  unsigned long lookups;
+
+  /**
+   * Number of group entries and options visited while traversing the option
+   * tree (nuts_getopts() and nuts_getopts_group() only).
+   */
+  unsigned long nodes;
+
+  /**
+   * Number of long name comparisons while traversing the option tree.
+   */
+  unsigned long compares;
+
+  /**
+   * Number of unknown options skipped due to
+   * #nuts_getopts_ignore_unknown_options.
+   */
+  unsigned long skipped;
+
+  /**
+   * Number of errors, indexed by the nuts_getopts_error_type.
+   */
+  unsigned long errors[NUTS_GETOPTS_ERROR_TYPES];
+
+  /**
+   * Time spent in the parser in CPU cycles (time stamp counter), resp.
+   * nanoseconds on platforms without a cycle counter.
+   */
+  uint64_t cycles;
+
+  /**
+   * The longest invocation of the parser, unit as #cycles.
+   */
+  uint64_t max_cycles;
+};
+
+/**
+ * Callback of an instrumented parser, invoked for each event.
+ *
+ * @param event The event, which is returned to the caller.
+ * @param stats The counters attached to the state, may be `NULL`.
+ * @param cycles The duration of the invocation, which created the event. See
+ *               nuts_getopts_stats#cycles for the unit.
+ * @param ctx The context passed to nuts_getopts_state_trace().
+ */
+typedef void (*nuts_getopts_trace)(const struct nuts_getopts_event* event, const struct nuts_getopts_stats* stats, uint64_t cycles, void* ctx);
+
+/**
+ * The state of the parser.
+ *
+ * The state of the parser. An instance of this type has to filled with zeroes
+ * before the first invocation of nuts_getopts(). Don't touch the state
+ * afterwards, nuts_getopts() stores its internal state in the variable.
+ *
+ * The members of the type is hidden for the public interface, there is no need
+ * to modify the variable directly.
+ */
+typedef struct {
+/** @cond SKIP_DOC */
+  int idx;
+  struct nuts_getopts_response* response;
+  struct nuts_getopts_response* responses;
+  const struct nuts_getopts_command_entry* command;
+  int command_done;
+  nuts_getopts_arena* arena;
+  struct nuts_getopts_stats* stats;
+  nuts_getopts_trace trace;
+  void* trace_ctx;
+/** @endcond */
+} nuts_getopts_state;
+
+/**
+ * A compiled option specification.
+ *
+ * The type is opaque, an instance is created with nuts_getopts_compile() and
+ * released with nuts_getopts_spec_free().
+ */
+typedef struct nuts_getopts_spec nuts_getopts_spec;
+
+/**
+ * The options found on the command line.
+ *
+ * The type is opaque, an instance is created with nuts_getopts_result_new()
+ * and released with nuts_getopts_result_free().
+ */
+typedef struct nuts_getopts_result nuts_getopts_result;
+
+/**
+ * Option lookup of a generated parser.
+ *
+ * An instance is emitted by the `nuts-getopts-gen` code generator (see
+ * \ref generated_parsers "Generated parsers") and passed to
+ * nuts_getopts_lookup_parse().
+ */
+struct nuts_getopts_lookup {
+  /**
+   * Returns the option with the short name `sname`, `NULL` if there is no
+   * such option.
+   */
+  const struct nuts_getopts_option* (*find_short)(char sname);
+
+  /**
+   * Returns the option with the long name `lname` of length `lname_len`
+   * (`lname` is not NUL-terminated), `NULL` if there is no such option.
+   */
+  const struct nuts_getopts_option* (*find_long)(const char* lname, int lname_len);
+};
+
+/**
+ * A compiled spec shared by several threads.
+ *
+ * The type is opaque, an instance is created with nuts_getopts_shared_new()
+ * and released with nuts_getopts_shared_free().
+ */
+typedef struct nuts_getopts_shared nuts_getopts_shared;
+
+/**
+ * A compiled command table.
+ *
+ * The type is opaque, an instance is created with
+ * nuts_getopts_commands_compile() and released with
+ * nuts_getopts_commands_free().
+ */
+typedef struct nuts_getopts_commands nuts_getopts_commands;
+
+/**
+ * An index over the long names of a compiled spec, which finds the options
+ * with a name similar to a misspelled one.
+ *
+ * The type is opaque, an instance is created with
+ * nuts_getopts_suggestions_compile() and released with
+ * nuts_getopts_suggestions_free().
+ */
+typedef struct nuts_getopts_suggestions nuts_getopts_suggestions;
+
+/**
+ * Calls the _nuts-getopts_ parser.
+ *
+ * Parses the command line arguments `argc`/`argv` and generates an event placed in the `event` argument.
+ * The event contains the option, argument, ... which was detected.
+ *
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param options Array with options, which can be detected by the parser. The
+ *                last entry of the array must contain only zeros. Passing
+ *                `NULL` to `options` is a convenient value for an empty array
+ *                (no options).
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. If no flags should be specified, `0` must be specified
+ *              here.
+ * @param state The state of the parser. The nuts_getopts_state instance has to
+ *              filled with zeroes before the first invocation of
+ *              nuts_getopts(). Don't touch the state afterwards,
+ *              nuts_getopts() stores its internal state in the variable.
+ * @param event The parser stores the next event in this variable. You only
+ *              need to read the variable after a successful nuts_getopts()
+ *              invocation. The parser will re-initialize its content with each
+ *              invation of nuts_getopts().
+ * @return The function returns
+ *         * `0`: Another event was generated and placed into the `event`
+ *                argument. Another nuts_getopts() invocation is required to
+ *                parse the next component.
+ *         * `-1`: All command line arguments were parsed. No further
+ *                 nuts_getopts() invocations are required.
+ */
+NUTS_GETOPTS_API int nuts_getopts(int argc, char* argv[], const struct nuts_getopts_option* options, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+
+/**
+ * Calls the _nuts-getopts_ parser (with grouped options).
  *
  * Parses the command line arguments `argc`/`argv` and generates an event placed in the `event` argument.
  * The event contains the option, argument, ... which was detected.
@@ -462,7 +1167,838 @@ int nuts_getopts(int argc, char* argv[], const struct nuts_getopts_option* optio
  *         * `-1`: All command line arguments were parsed. No further
  *                 nuts_getopts_group() invocations are required.
  */
-int nuts_getopts_group(int argc, char* argv[], const struct nuts_getopts_option_group* groups, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+NUTS_GETOPTS_API int nuts_getopts_group(int argc, char* argv[], const struct nuts_getopts_option_group* groups, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+
+/**
+ * A stream of command line arguments.
+ *
+ * The stream is initialized with nuts_getopts_stream_init(),
+ * nuts_getopts_stream_init_fd() or nuts_getopts_stream_init_buffer() and
+ * passed to nuts_getopts_stream_group() resp. nuts_getopts_stream_spec().
+ *
+ * The members of the type are hidden for the public interface, there is no
+ * need to modify the variable directly.
+ */
+typedef struct {
+/** @cond SKIP_DOC */
+  long (*read)(void* ctx, char* buf, size_t len);
+  void* ctx;
+  int fd;
+  char delim;
+  char* buf;
+  size_t size;
+  size_t head;
+  size_t tail;
+  int eof;
+  int skip;
+  int error;
+/** @endcond */
+} nuts_getopts_stream;
+
+/**
+ * Initializes the state of the parser.
+ *
+ * Fills the state with zeros, which is the same as `nuts_getopts_state state
+ * = { 0 };`. Additionally the memory the parser allocates while parsing
+ * (e.g. for response files) is taken from `arena`.
+ *
+ * @param state The state of the parser.
+ * @param arena The arena, `NULL` for the heap.
+ */
+NUTS_GETOPTS_API void nuts_getopts_state_init(nuts_getopts_state* state, nuts_getopts_arena* arena);
+
+/**
+ * Releases resources allocated by the parser.
+ *
+ * When response files are expanded (see #nuts_getopts_response_files), the
+ * parser keeps the files mapped into memory as the reported events reference
+ * them. Call this function, when the events are not needed anymore. The
+ * state is reset and can be re-used for another parser run. The arena passed
+ * to nuts_getopts_state_init() and the counters and callback attached by
+ * nuts_getopts_state_trace() are kept.
+ *
+ * @param state The state of the parser.
+ */
+NUTS_GETOPTS_API void nuts_getopts_state_release(nuts_getopts_state* state);
+
+/**
+ * Instruments the parser.
+ *
+ * Attaches counters and a callback to the state. Further invocations of the
+ * parser with the state accumulate into `stats` and invoke `trace` for each
+ * event. Passing `NULL` for both detaches the instrumentation.
+ *
+ * @param state The state of the parser.
+ * @param stats The counters, which are updated by the parser. Can be `NULL`.
+ * @param trace Invoked for each event, can be `NULL`.
+ * @param ctx Passed to `trace`.
+ * @return `0` on success. `-1` if the library is built without
+ *         instrumentation (`errno` is set to `ENOTSUP`).
+ */
+NUTS_GETOPTS_API int nuts_getopts_state_trace(nuts_getopts_state* state, struct nuts_getopts_stats* stats, nuts_getopts_trace trace, void* ctx);
+
+/**
+ * Initializes an arena.
+ *
+ * @param arena The arena to be initialized.
+ * @param buf The memory the arena hands out first. Can be `NULL`, if the
+ *            arena should only use the growth callback.
+ * @param size The size of `buf`.
+ * @param grow Optional growth callback. If `size` is not `0`, it allocates
+ *             and returns a block of `size` bytes (`NULL` on failure),
+ *             otherwise it releases `block`. Pass nuts_getopts_arena_heap()
+ *             for blocks from the heap or `NULL`, if the arena must not grow
+ *             beyond `buf`.
+ * @param ctx Context passed to `grow`.
+ */
+NUTS_GETOPTS_API void nuts_getopts_arena_init(nuts_getopts_arena* arena, void* buf, size_t size, void* (*grow)(void* ctx, void* block, size_t size), void* ctx);
+
+/**
+ * Allocates memory from an arena.
+ *
+ * @param arena The arena.
+ * @param size Number of bytes to allocate.
+ * @return Zeroed memory, suitably aligned for any type used by the library.
+ *         If the arena is exhausted and cannot grow, `NULL` is returned and
+ *         `errno` is set to `ENOMEM`.
+ */
+NUTS_GETOPTS_API void* nuts_getopts_arena_alloc(nuts_getopts_arena* arena, size_t size);
+
+/**
+ * Releases all memory allocated from an arena.
+ *
+ * The blocks of the growth callback are returned, the arena starts over with
+ * the buffer passed to nuts_getopts_arena_init().
+ *
+ * @param arena The arena.
+ */
+NUTS_GETOPTS_API void nuts_getopts_arena_release(nuts_getopts_arena* arena);
+
+/**
+ * Growth callback for nuts_getopts_arena_init(), which uses `malloc(3)` and
+ * `free(3)`.
+ */
+NUTS_GETOPTS_API void* nuts_getopts_arena_heap(void* ctx, void* block, size_t size);
+
+/**
+ * Compiles an option tree into a nuts_getopts_spec.
+ *
+ * Builds an index over all short and long names of the options in `groups`.
+ * Short names are placed into a table directly indexed by the character, long
+ * names into a hash table. The index is used by nuts_getopts_spec_parse().
+ *
+ * The option tree is flattened into a single contiguous memory block: the
+ * attributes of the options (short names, length and hash of the long names)
+ * are kept in parallel arrays and the long names are copied into a string
+ * pool. Events still report the options of `groups`, thus `groups` and all
+ * its option arrays must be valid as long as the spec is in use.
+ *
+ * Each short and long name must be unique in the whole tree. Unlike
+ * nuts_getopts_group(), which silently selects the first match in tree order,
+ * compilation fails for a duplicate name.
+ *
+ * @param groups Array with option groups to be compiled. The last entry of the
+ *               array must contain only zeros. Passing `NULL` to `groups`
+ *               creates a spec without any options.
+ * @return The compiled spec, which must be released with
+ *         nuts_getopts_spec_free(). On error `NULL` is returned and `errno` is
+ *         set:
+ *         * `EEXIST`: A short or long name is defined more than once.
+ *         * `ENOMEM`: Memory allocation failed.
+ */
+NUTS_GETOPTS_API nuts_getopts_spec* nuts_getopts_compile(const struct nuts_getopts_option_group* groups);
+
+/**
+ * Compiles an option tree into a nuts_getopts_spec (in an arena).
+ *
+ * Works like nuts_getopts_compile(), but the spec is allocated from `arena`.
+ *
+ * @param groups Array with option groups to be compiled.
+ * @param arena The arena, `NULL` for the heap.
+ * @return The compiled spec, `NULL` on error (with `errno` set).
+ */
+NUTS_GETOPTS_API nuts_getopts_spec* nuts_getopts_compile_arena(const struct nuts_getopts_option_group* groups, nuts_getopts_arena* arena);
+
+/**
+ * Releases a spec created by nuts_getopts_compile().
+ *
+ * A spec allocated from an arena is released together with the arena, the
+ * function is a no-op then.
+ *
+ * @param spec The spec to be released. Passing `NULL` is a no-op.
+ */
+NUTS_GETOPTS_API void nuts_getopts_spec_free(nuts_getopts_spec* spec);
+
+/**
+ * Calls the _nuts-getopts_ parser (with a compiled spec).
+ *
+ * Works like nuts_getopts_group() but looks up options in the index of a
+ * compiled spec. A lookup takes constant time, regardless of the number of
+ * configured options. Long names are matched exactly, unless the
+ * #nuts_getopts_allow_abbreviations flag is passed. Then abbreviations are
+ * resolved by means of a trie in time proportional to the length of the
+ * name.
+ *
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param spec The spec created by nuts_getopts_compile().
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. If no flags should be specified, `0` must be specified
+ *              here.
+ * @param state The state of the parser. The nuts_getopts_state instance has to
+ *              filled with zeroes before the first invocation of
+ *              nuts_getopts_spec_parse(). Don't touch the state afterwards,
+ *              nuts_getopts_spec_parse() stores its internal state in the
+ *              variable.
+ * @param event The parser stores the next event in this variable. You only
+ *              need to read the variable after a successful
+ *              nuts_getopts_spec_parse() invocation.
+ * @return The function returns
+ *         * `0`: Another event was generated and placed into the `event`
+ *                argument. Another nuts_getopts_spec_parse() invocation is
+ *                required to parse the next component.
+ *         * `-1`: All command line arguments were parsed. No further
+ *                 nuts_getopts_spec_parse() invocations are required.
+ */
+NUTS_GETOPTS_API int nuts_getopts_spec_parse(int argc, char* argv[], const nuts_getopts_spec* spec, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+
+/**
+ * Creates a shared spec.
+ *
+ * @param spec The initial spec, created by nuts_getopts_compile(). The shared
+ *             spec takes over the ownership.
+ * @return The shared spec, which must be released with
+ *         nuts_getopts_shared_free(). On error `NULL` is returned and `errno`
+ *         is set.
+ */
+NUTS_GETOPTS_API nuts_getopts_shared* nuts_getopts_shared_new(nuts_getopts_spec* spec);
+
+/**
+ * Creates a shared spec (in an arena).
+ *
+ * Works like nuts_getopts_shared_new(), but the shared spec is allocated from
+ * `arena`.
+ *
+ * @param spec The initial spec, created by nuts_getopts_compile(). The shared
+ *             spec takes over the ownership.
+ * @param arena The arena, `NULL` for the heap.
+ * @return The shared spec, `NULL` on error (with `errno` set).
+ */
+NUTS_GETOPTS_API nuts_getopts_shared* nuts_getopts_shared_new_arena(nuts_getopts_spec* spec, nuts_getopts_arena* arena);
+
+/**
+ * Releases a shared spec together with its current spec.
+ *
+ * No reader must use the shared spec anymore.
+ *
+ * @param shared The shared spec. Passing `NULL` is a no-op.
+ */
+NUTS_GETOPTS_API void nuts_getopts_shared_free(nuts_getopts_shared* shared);
+
+/**
+ * Enters a read-side section of a shared spec.
+ *
+ * The returned spec remains valid until the section is left with
+ * nuts_getopts_shared_release(), even if another thread swaps the spec in the
+ * meantime. The function does not block, it only increments a counter. Keep
+ * the section short, a pending nuts_getopts_shared_swap() waits for it.
+ *
+ * The events produced in the section reference the options of the option
+ * tree, not the spec, thus they are still valid after the section, as long as
+ * the option tree is valid.
+ *
+ * @param shared The shared spec.
+ * @param ticket Receives a value, which must be passed to
+ *               nuts_getopts_shared_release().
+ * @return The current spec.
+ */
+NUTS_GETOPTS_API const nuts_getopts_spec* nuts_getopts_shared_acquire(nuts_getopts_shared* shared, int* ticket);
+
+/**
+ * Leaves a read-side section of a shared spec.
+ *
+ * @param shared The shared spec.
+ * @param ticket The ticket returned by nuts_getopts_shared_acquire().
+ */
+NUTS_GETOPTS_API void nuts_getopts_shared_release(nuts_getopts_shared* shared, int ticket);
+
+/**
+ * Replaces the spec of a shared spec.
+ *
+ * The new spec is visible to all readers entering afterwards. The function
+ * waits until all readers, which could still use the old spec, have left
+ * their section. Concurrent invocations are serialized.
+ *
+ * @param shared The shared spec.
+ * @param spec The new spec. The shared spec takes over the ownership.
+ * @return The old spec. It is not used by any reader anymore and must be
+ *         released by the caller.
+ */
+NUTS_GETOPTS_API nuts_getopts_spec* nuts_getopts_shared_swap(nuts_getopts_shared* shared, nuts_getopts_spec* spec);
+
+/**
+ * Creates a result store for the options of a compiled spec.
+ *
+ * The store records the options reported by the parser, see
+ * nuts_getopts_result_parse() resp. nuts_getopts_result_record(). Afterwards
+ * nuts_getopts_is_set(), nuts_getopts_count(), nuts_getopts_value() and
+ * nuts_getopts_typed_value() answer for an option in constant time, there is
+ * no need to dispatch the option events yourself.
+ *
+ * @code
+ * nuts_getopts_result* result = nuts_getopts_result_new(spec);
+ *
+ * while (nuts_getopts_result_parse(argc, argv, result, 0, &state, &ev) == 0) {
+ *   // Handle tool, argument and error events
+ * }
+ *
+ * if (nuts_getopts_is_set(result, &options[0]))
+ *   verbose = nuts_getopts_typed_value(result, &options[0]).i64;
+ * @endcode
+ *
+ * @param spec The spec created by nuts_getopts_compile(). It must be valid as
+ *             long as the result is in use.
+ * @return The result store, which must be released with
+ *         nuts_getopts_result_free(). On error `NULL` is returned and `errno`
+ *         is set to `ENOMEM`.
+ */
+NUTS_GETOPTS_API nuts_getopts_result* nuts_getopts_result_new(const nuts_getopts_spec* spec);
+
+/**
+ * Creates a result store for the options of a compiled spec (in an arena).
+ *
+ * Works like nuts_getopts_result_new(), but the store and the arrays reserved
+ * by nuts_getopts_result_prepare() are allocated from `arena`.
+ *
+ * @param spec The spec created by nuts_getopts_compile().
+ * @param arena The arena, `NULL` for the heap.
+ * @return The result store, `NULL` on error (with `errno` set).
+ */
+NUTS_GETOPTS_API nuts_getopts_result* nuts_getopts_result_new_arena(const nuts_getopts_spec* spec, nuts_getopts_arena* arena);
+
+/**
+ * Releases a result store created by nuts_getopts_result_new().
+ *
+ * @param result The store to be released. Passing `NULL` is a no-op.
+ */
+NUTS_GETOPTS_API void nuts_getopts_result_free(nuts_getopts_result* result);
+
+/**
+ * Forgets all recorded options, so the store can be re-used for another
+ * command line.
+ *
+ * @param result The result store.
+ */
+NUTS_GETOPTS_API void nuts_getopts_result_clear(nuts_getopts_result* result);
+
+/**
+ * Reserves the arrays of the #nuts_getopts_multi_argument options.
+ *
+ * A counting pre-pass over the command line determines the number of
+ * occurrences of each #nuts_getopts_multi_argument option. The arrays for
+ * the values of all options are then reserved with a single allocation (no
+ * allocation at all, if there are no such options on the command line).
+ * The pre-pass only scans the arguments and looks up the options, values
+ * are not converted.
+ *
+ * If the #nuts_getopts_response_files flag is passed and the command line
+ * references a response file, the pre-pass has to run the complete parser,
+ * which maps each response file a second time. This doubles the cost of
+ * parsing. For long command lines in response files consider recording the
+ * events into your own arrays (e.g. allocated from a nuts_getopts_arena)
+ * instead.
+ *
+ * nuts_getopts_result_parse() calls the function on its first invocation,
+ * you only need to call it, if you record the events yourself with
+ * nuts_getopts_result_record().
+ *
+ * @param result The result store.
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param flags The flags, which are passed to the parser.
+ * @return `0` on success. On error `-1` is returned and `errno` is set to
+ *         `ENOMEM`.
+ */
+NUTS_GETOPTS_API int nuts_getopts_result_prepare(nuts_getopts_result* result, int argc, char* argv[], int flags);
+
+/**
+ * Records an option event.
+ *
+ * Use this function, if you collect the events yourself, e.g. with
+ * nuts_getopts_parse_all(). The value of a #nuts_getopts_multi_argument
+ * option is only appended to its array, if there is room, which was reserved
+ * by nuts_getopts_result_prepare().
+ *
+ * @param result The result store.
+ * @param event The event to be recorded.
+ * @return `0` if the option was recorded, `-1` if `event` is not a
+ *         #nuts_getopts_option_event of an option of the spec.
+ */
+NUTS_GETOPTS_API int nuts_getopts_result_record(nuts_getopts_result* result, const struct nuts_getopts_event* event);
+
+/**
+ * Calls the _nuts-getopts_ parser (with a result store).
+ *
+ * Works like nuts_getopts_spec_parse() with the spec of `result`, but option
+ * events are recorded in `result` and not reported. Only tool, argument and
+ * error events are reported. The first invocation calls
+ * nuts_getopts_result_prepare(). If it fails, a
+ * #nuts_getopts_error_event of type #nuts_getopts_out_of_memory is
+ * reported.
+ *
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param result The result store created by nuts_getopts_result_new().
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. If no flags should be specified, `0` must be specified
+ *              here.
+ * @param state The state of the parser. The nuts_getopts_state instance has to
+ *              filled with zeroes before the first invocation of
+ *              nuts_getopts_result_parse(). Don't touch the state afterwards.
+ * @param event The parser stores the next event in this variable.
+ * @return The function returns
+ *         * `0`: Another event was generated and placed into the `event`
+ *                argument.
+ *         * `-1`: All command line arguments were parsed.
+ */
+NUTS_GETOPTS_API int nuts_getopts_result_parse(int argc, char* argv[], nuts_getopts_result* result, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+
+/**
+ * Tests whether an option was found on the command line.
+ *
+ * @param result The result store.
+ * @param option The option, an element of the option tree compiled into the
+ *               spec of `result`.
+ * @return `1` if the option was recorded, `0` otherwise.
+ */
+NUTS_GETOPTS_API int nuts_getopts_is_set(const nuts_getopts_result* result, const struct nuts_getopts_option* option);
+
+/**
+ * Returns the number of occurrences of an option.
+ *
+ * @param result The result store.
+ * @param option The option.
+ * @return The number of recorded occurrences.
+ */
+NUTS_GETOPTS_API int nuts_getopts_count(const nuts_getopts_result* result, const struct nuts_getopts_option* option);
+
+/**
+ * Returns the option-argument of the last occurrence of an option.
+ *
+ * The value is not NUL-terminated, if it was read from a response file, use
+ * nuts_getopts_value_len() to get its length.
+ *
+ * @param result The result store.
+ * @param option The option.
+ * @return The value, `NULL` if the option was not recorded or has no
+ *         argument.
+ */
+NUTS_GETOPTS_API const char* nuts_getopts_value(const nuts_getopts_result* result, const struct nuts_getopts_option* option);
+
+/**
+ * Returns the length of nuts_getopts_value().
+ *
+ * @param result The result store.
+ * @param option The option.
+ * @return The length of the value, `0` if there is no value.
+ */
+NUTS_GETOPTS_API int nuts_getopts_value_len(const nuts_getopts_result* result, const struct nuts_getopts_option* option);
+
+/**
+ * Returns the values of all occurrences of an option.
+ *
+ * Intended for #nuts_getopts_multi_argument options, the number of values is
+ * returned by nuts_getopts_count(). The values are not NUL-terminated, if
+ * they were read from a response file, their lengths are stored in `lens`.
+ *
+ * @param result The result store.
+ * @param option The option.
+ * @param lens If not `NULL`, receives an array with the lengths of the
+ *             values.
+ * @return The values in the order of the command line, `NULL` if the option
+ *         was not recorded, is not a #nuts_getopts_multi_argument option or
+ *         if the room reserved by nuts_getopts_result_prepare() was
+ *         exceeded.
+ */
+NUTS_GETOPTS_API const char* const* nuts_getopts_values(const nuts_getopts_result* result, const struct nuts_getopts_option* option, const int** lens);
+
+/**
+ * Returns the converted option-argument of the last occurrence of an option.
+ *
+ * @param result The result store.
+ * @param option The option with a {@link nuts_getopts_option#type type}.
+ * @return The converted value, all zeros if the option was not recorded.
+ */
+NUTS_GETOPTS_API union nuts_getopts_typed nuts_getopts_typed_value(const nuts_getopts_result* result, const struct nuts_getopts_option* option);
+
+/**
+ * Calls the _nuts-getopts_ parser (with a generated lookup).
+ *
+ * Works like nuts_getopts_spec_parse() but looks up options by the functions
+ * of a generated parser, see \ref generated_parsers "Generated parsers".
+ * The #nuts_getopts_allow_abbreviations flag is not supported.
+ *
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param lookup The lookup emitted by the code generator.
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. If no flags should be specified, `0` must be specified
+ *              here.
+ * @param state The state of the parser. The nuts_getopts_state instance has to
+ *              filled with zeroes before the first invocation of
+ *              nuts_getopts_lookup_parse(). Don't touch the state afterwards.
+ * @param event The parser stores the next event in this variable.
+ * @return The function returns
+ *         * `0`: Another event was generated and placed into the `event`
+ *                argument.
+ *         * `-1`: All command line arguments were parsed.
+ */
+NUTS_GETOPTS_API int nuts_getopts_lookup_parse(int argc, char* argv[], const struct nuts_getopts_lookup* lookup, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+
+/**
+ * Parses all command line arguments in one call (with a compiled spec).
+ *
+ * Instead of returning to the caller for each event, the parser classifies
+ * the command line arguments in a loop and places the events in the
+ * caller-supplied array `events`. The events are stored in the same order
+ * nuts_getopts_spec_parse() would report them. Only the members belonging to
+ * the {@link nuts_getopts_event#type type} of an event are filled.
+ *
+ * If the array is full before all arguments are parsed, the function returns
+ * and the progress is kept in `state`. Pass the same `state` to another
+ * invocation to continue with the next argument.
+ *
+ * @code
+ * struct nuts_getopts_event events[64];
+ * int count;
+ * int result;
+ *
+ * do {
+ *   result = nuts_getopts_parse_all(argc, argv, spec, 0, &state, events, 64, &count);
+ *
+ *   for (int i = 0; i < count; i++)
+ *     handle_event(&events[i]);
+ * } while (result == 0);
+ * @endcode
+ *
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param spec The spec created by nuts_getopts_compile().
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. If no flags should be specified, `0` must be specified
+ *              here.
+ * @param state The state of the parser. The nuts_getopts_state instance has to
+ *              filled with zeroes before the first invocation of
+ *              nuts_getopts_parse_all(). Don't touch the state afterwards.
+ * @param events Array, where the events are stored.
+ * @param size Number of elements in `events`.
+ * @param count Number of events stored in `events` by this invocation.
+ * @return The function returns
+ *         * `0`: The array is full, but there are still arguments to be
+ *                parsed. Another nuts_getopts_parse_all() invocation is
+ *                required to parse the remaining arguments.
+ *         * `-1`: All command line arguments were parsed. No further
+ *                 nuts_getopts_parse_all() invocations are required.
+ */
+NUTS_GETOPTS_API int nuts_getopts_parse_all(int argc, char* argv[], const nuts_getopts_spec* spec, int flags, nuts_getopts_state* state, struct nuts_getopts_event* events, int size, int* count);
+
+/**
+ * Parses all command line arguments on several threads (with a compiled
+ * spec).
+ *
+ * Each command line argument is classified independently from its
+ * neighbours. The function splits `argv` into chunks, which are parsed
+ * concurrently against the (read-only) `spec`. The events of all chunks are
+ * merged into `events` in the order of the command line arguments, thus the
+ * result is the same as the events reported by nuts_getopts_parse_all().
+ *
+ * Splitting `argv` only pays off for very large argument vectors, small
+ * argument vectors are parsed by the calling thread. Response files are not
+ * expanded, the #nuts_getopts_response_files flag is ignored.
+ *
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param spec The spec created by nuts_getopts_compile().
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. If no flags should be specified, `0` must be specified
+ *              here.
+ * @param nthreads The maximum number of threads used for parsing. If set to
+ *                 `0`, the number of online processors is used.
+ * @param events Array, where the events are stored. Each argument produces at
+ *               most one event, so the array must have room for `argc`
+ *               events.
+ * @return The number of events stored in `events`. On error `-1` is returned
+ *         and `errno` is set.
+ */
+NUTS_GETOPTS_API int nuts_getopts_parse_parallel(int argc, char* argv[], const nuts_getopts_spec* spec, int flags, int nthreads, struct nuts_getopts_event* events);
+
+/**
+ * Compiles an array of commands into a nuts_getopts_commands table.
+ *
+ * The command names are placed into a hash table, the options of each command
+ * are compiled like nuts_getopts_compile() does. The options of a command
+ * with a nuts_getopts_command#resolve function are compiled on first use.
+ * The table only references the commands, thus `commands` and all option
+ * groups must be valid as long as the table is in use.
+ *
+ * The table can be shared by several threads, a command compiled on demand is
+ * published atomically.
+ *
+ * @param commands Array with the commands. The last entry of the array must
+ *                 have a `NULL` name. Passing `NULL` creates an empty table.
+ * @return The compiled table, which must be released with
+ *         nuts_getopts_commands_free(). On error `NULL` is returned and
+ *         `errno` is set:
+ *         * `EEXIST`: A command name is defined more than once or an option
+ *                     name is defined more than once in a command (without
+ *                     a resolver).
+ *         * `ENOMEM`: Memory allocation failed.
+ */
+NUTS_GETOPTS_API nuts_getopts_commands* nuts_getopts_commands_compile(const struct nuts_getopts_command* commands);
+
+/**
+ * Compiles an array of commands into a nuts_getopts_commands table (in an
+ * arena).
+ *
+ * Works like nuts_getopts_commands_compile(), but the table and the specs of
+ * the commands, even those compiled on demand, are allocated from `arena`.
+ * Such a table must not be shared by several threads.
+ *
+ * @param commands Array with the commands.
+ * @param arena The arena, `NULL` for the heap.
+ * @return The compiled table, `NULL` on error (with `errno` set).
+ */
+NUTS_GETOPTS_API nuts_getopts_commands* nuts_getopts_commands_compile_arena(const struct nuts_getopts_command* commands, nuts_getopts_arena* arena);
+
+/**
+ * Releases a table created by nuts_getopts_commands_compile().
+ *
+ * @param commands The table to be released. Passing `NULL` is a no-op.
+ */
+NUTS_GETOPTS_API void nuts_getopts_commands_free(nuts_getopts_commands* commands);
+
+/**
+ * Calls the _nuts-getopts_ parser (with commands).
+ *
+ * Works like nuts_getopts_spec_parse(), but the first argument (the first
+ * command line argument, which is not an option) is looked up in `commands`.
+ * If it names a command, a #nuts_getopts_command_event is emitted. From then
+ * on the options of the command are recognized in addition to the options of
+ * `spec`. If a name is defined by both, the option of the command wins. If the
+ * first argument is not a command, it is reported as an ordinary
+ * #nuts_getopts_argument_event. Later arguments are never looked up.
+ *
+ * If the options of a command are resolved on demand and cannot be resolved
+ * or compiled, a #nuts_getopts_invalid_command error is emitted and only
+ * the global options are recognized.
+ *
+ * @param argc Number of arguments in `argv`.
+ * @param argv Command line arguments to be parsed.
+ * @param spec The global options, created by nuts_getopts_compile().
+ * @param commands The commands created by nuts_getopts_commands_compile().
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. If no flags should be specified, `0` must be specified
+ *              here.
+ * @param state The state of the parser. The nuts_getopts_state instance has to
+ *              filled with zeroes before the first invocation of
+ *              nuts_getopts_command_parse(). Don't touch the state
+ *              afterwards, the selected command is stored in the state.
+ * @param event The parser stores the next event in this variable. You only
+ *              need to read the variable after a successful
+ *              nuts_getopts_command_parse() invocation.
+ * @return The function returns
+ *         * `0`: Another event was generated and placed into the `event`
+ *                argument. Another nuts_getopts_command_parse() invocation is
+ *                required to parse the next component.
+ *         * `-1`: All command line arguments were parsed. No further
+ *                 nuts_getopts_command_parse() invocations are required.
+ */
+NUTS_GETOPTS_API int nuts_getopts_command_parse(int argc, char* argv[], const nuts_getopts_spec* spec, const nuts_getopts_commands* commands, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+
+/**
+ * Initializes a stream, which reads from a callback.
+ *
+ * @param stream The stream to be initialized.
+ * @param read Callback, which reads up to `len` bytes into `buf`. It returns
+ *             the number of bytes read, `0` at the end of the input or a
+ *             negative value on error (with `errno` set).
+ * @param ctx Context passed to `read`.
+ * @param delim The character, which separates the arguments.
+ * @param buf The buffer, where the input is stored. The size of the buffer
+ *            limits the length of a single argument to `size - 1`
+ *            characters, a longer argument is reported as
+ *            #nuts_getopts_argument_too_long.
+ * @param size The size of `buf`.
+ */
+NUTS_GETOPTS_API void nuts_getopts_stream_init(nuts_getopts_stream* stream, long (*read)(void* ctx, char* buf, size_t len), void* ctx, char delim, char* buf, size_t size);
+
+/**
+ * Initializes a stream, which reads from a file descriptor.
+ *
+ * The descriptor can be a file, pipe, socket, ... The stream does not close
+ * the descriptor.
+ *
+ * @param stream The stream to be initialized.
+ * @param fd The file descriptor to read from.
+ * @param delim The character, which separates the arguments.
+ * @param buf The buffer, where the input is stored. The size of the buffer
+ *            limits the length of a single argument to `size - 1`
+ *            characters.
+ * @param size The size of `buf`.
+ */
+NUTS_GETOPTS_API void nuts_getopts_stream_init_fd(nuts_getopts_stream* stream, int fd, char delim, char* buf, size_t size);
+
+/**
+ * Initializes a stream, which reads from a buffer.
+ *
+ * The arguments are parsed in place, the reported strings point into `data`
+ * and are not NUL-terminated (unless `delim` is `\0`).
+ *
+ * @param stream The stream to be initialized.
+ * @param data The buffer with the arguments.
+ * @param len The size of `data`.
+ * @param delim The character, which separates the arguments.
+ */
+NUTS_GETOPTS_API void nuts_getopts_stream_init_buffer(nuts_getopts_stream* stream, const char* data, size_t len, char delim);
+
+/**
+ * Returns the error, which occured while reading the stream.
+ *
+ * @param stream The stream.
+ * @return The `errno` value of the failed read operation, `0` if the stream
+ *         was read successfully.
+ */
+NUTS_GETOPTS_API int nuts_getopts_stream_error(const nuts_getopts_stream* stream);
+
+/**
+ * Calls the _nuts-getopts_ parser (on a stream).
+ *
+ * Works like nuts_getopts_group() but reads the arguments from `stream`.
+ *
+ * Strings reported by the event point into the buffer of the stream. For
+ * streams reading from a callback or file descriptor they are NUL-terminated.
+ * They are only valid until the next invocation, when the buffer is refilled.
+ *
+ * @param stream The stream to read from.
+ * @param groups Array with option groups, which can be detected by the parser.
+ *               The last entry of the array must contain only zeros.
+ * @param flags Flags, which controls the parser. Multiple flags are OR'ed
+ *              together. See #nuts_getopts_flags for a list of supported
+ *              flags. #nuts_getopts_response_files is not supported.
+ * @param event The parser stores the next event in this variable.
+ * @return The function returns
+ *         * `0`: Another event was generated and placed into the `event`
+ *                argument.
+ *         * `-1`: The stream is exhausted or an error occured while reading
+ *                 the stream, see nuts_getopts_stream_error().
+ */
+NUTS_GETOPTS_API int nuts_getopts_stream_group(nuts_getopts_stream* stream, const struct nuts_getopts_option_group* groups, int flags, struct nuts_getopts_event* event);
+
+/**
+ * Calls the _nuts-getopts_ parser (on a stream with a compiled spec).
+ *
+ * Works like nuts_getopts_stream_group() but looks up options in the index of
+ * a compiled spec.
+ *
+ * @param stream The stream to read from.
+ * @param spec The spec created by nuts_getopts_compile().
+ * @param flags Flags, which controls the parser.
+ * @param event The parser stores the next event in this variable.
+ * @return `0` if another event was generated, `-1` if the stream is exhausted.
+ */
+NUTS_GETOPTS_API int nuts_getopts_stream_spec(nuts_getopts_stream* stream, const nuts_getopts_spec* spec, int flags, struct nuts_getopts_event* event);
+
+/**
+ * Splits a command line string into words.
+ *
+ * The string is split by the quoting rules of a POSIX shell:
+ *
+ * * Unquoted blanks (space, tab, newline) separate the words.
+ * * A backslash preserves the literal value of the next character, a
+ *   backslash-newline is removed.
+ * * Characters enclosed in single quotes are taken literally.
+ * * Inside double quotes a backslash only escapes `$`, `` ` ``, `"`, `\`
+ *   and newline, otherwise it is preserved.
+ *
+ * No expansions are performed. An empty quoted string (`''` or `""`) is an
+ * empty word.
+ *
+ * The string is modified in place: the words are unquoted and terminated by
+ * `\0` within `buf`, `argv` receives pointers into `buf`. On failure the
+ * content of `buf` is undefined.
+ *
+ * @param buf The NUL-terminated string to split.
+ * @param argv Receives the words, terminated by a `NULL` pointer.
+ * @param size Number of elements of `argv`, including the terminating `NULL`
+ *             pointer.
+ * @return The number of words on success. On failure `-1` is returned and
+ *         `errno` is set:
+ *         * `EINVAL`: A quote is not closed or the string ends with a
+ *                     backslash.
+ *         * `E2BIG`: `argv` has not enough room for all words.
+ */
+NUTS_GETOPTS_API int nuts_getopts_split(char* buf, char* argv[], int size);
+
+/**
+ * Creates the suggestion index of a compiled spec.
+ *
+ * The index references the long names of `spec`, the spec must be valid as
+ * long as the index is in use. Options without a long name are not indexed.
+ *
+ * @param spec The compiled spec.
+ * @return The index, which must be released with
+ *         nuts_getopts_suggestions_free(). On error `NULL` is returned and
+ *         `errno` is set to `ENOMEM`.
+ */
+NUTS_GETOPTS_API nuts_getopts_suggestions* nuts_getopts_suggestions_compile(const nuts_getopts_spec* spec);
+
+/**
+ * Creates the suggestion index of a compiled spec (in an arena).
+ *
+ * Works like nuts_getopts_suggestions_compile(), but the index is allocated
+ * from `arena`.
+ *
+ * @param spec The compiled spec.
+ * @param arena The arena, `NULL` for the heap.
+ * @return The index, `NULL` on error (with `errno` set).
+ */
+NUTS_GETOPTS_API nuts_getopts_suggestions* nuts_getopts_suggestions_compile_arena(const nuts_getopts_spec* spec, nuts_getopts_arena* arena);
+
+/**
+ * Releases an index created by nuts_getopts_suggestions_compile().
+ *
+ * @param suggestions The index to be released. Passing `NULL` is a no-op.
+ */
+NUTS_GETOPTS_API void nuts_getopts_suggestions_free(nuts_getopts_suggestions* suggestions);
+
+/**
+ * Finds the options with a long name similar to `name`.
+ *
+ * The similarity is the Levenshtein distance (number of inserted, removed or
+ * replaced characters). Leading dashes and a value (`=...`) are stripped from
+ * `name`, thus the option of an #nuts_getopts_invalid_option error can be
+ * passed as it is. For a short option (a single leading dash, e.g. `-q`)
+ * nothing is reported. The function can be called by several threads at once.
+ *
+ * @param suggestions The index.
+ * @param name The misspelled name, not necessarily NUL-terminated.
+ * @param name_len Length of `name`.
+ * @param max_distance Options with a larger distance are not reported.
+ * @param options Receives the options, the closest first. Options with the
+ *                same distance are ordered as in the spec.
+ * @param size Number of elements of `options`, at most 32 options are
+ *             reported.
+ * @return The number of options stored in `options`, `-1` if memory
+ *         allocation failed (only for specs with long names of 128 characters
+ *         or more).
+ */
+NUTS_GETOPTS_API int nuts_getopts_suggest(const nuts_getopts_suggestions* suggestions, const char* name, int name_len, int max_distance, const struct nuts_getopts_option** options, int size);
 
 #ifdef __cplusplus
 }
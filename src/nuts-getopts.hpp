@@ -0,0 +1,471 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#ifndef NUTS_GETOPTS_HPP
+#define NUTS_GETOPTS_HPP
+
+/**
+ * @file nuts-getopts.hpp
+ *
+ * C++17 interface of _nuts-getopts_.
+ *
+ * nuts::getopts::spec is a `constexpr` variant of nuts_getopts_compile(): the
+ * options are declared as a `constexpr` table, which is checked for duplicate
+ * short and long names and indexed by the compiler. Thus a C++ tool gets a
+ * lookup specialized to its exact option set without building an index at
+ * runtime.
+ *
+ * @code
+ * static constexpr nuts::getopts::spec options{{
+ *   { 'v', "verbose", nuts_getopts_required_argument, nuts_getopts_int64_value },
+ *   {  0,  "quiet",   nuts_getopts_no_argument },
+ *   { 'f', nullptr,   nuts_getopts_required_argument }
+ * }};
+ *
+ * static_assert(options.find_long("quiet") != nullptr);
+ *
+ * while (nuts_getopts_lookup_parse(argc, argv, &nuts::getopts::lookup<options>, 0, &state, &ev) == 0) {
+ *   ...
+ * }
+ * @endcode
+ *
+ * nuts::getopts::parse() exposes the parser as a range of
+ * nuts::getopts::event_view, which can be iterated with a range-based `for`
+ * loop. The strings of an event are reported as `std::string_view`, whose
+ * length is taken from the event, so there is no need to call `strlen(3)`.
+ *
+ * @code
+ * for (auto ev : nuts::getopts::parse(argc, argv, groups)) {
+ *   if (ev.type() == nuts_getopts_argument_event)
+ *     files.emplace_back(ev.str());
+ * }
+ * @endcode
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#include "nuts-getopts.h"
+
+namespace nuts::getopts {
+
+/** @cond SKIP_DOC */
+namespace detail {
+
+// FNV-1a, the same hash as used by nuts_getopts_compile().
+constexpr std::uint32_t hash(std::string_view str) {
+  std::uint32_t hash = 2166136261u;
+
+  for (char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+// Keep the load factor below 50%.
+constexpr std::size_t table_size(std::size_t n) {
+  std::size_t size = 8;
+
+  while (size < n * 2)
+    size <<= 1;
+
+  return size;
+}
+
+}  // namespace detail
+/** @endcond */
+
+/**
+ * A compiled option table, which can be built at compile time.
+ *
+ * The table holds a copy of the `N` options passed to the constructor,
+ * terminated by an empty option, and an index over their short and long
+ * names. If the table is declared `constexpr`, a duplicate name is reported
+ * by the compiler, otherwise the constructor throws `std::invalid_argument`.
+ *
+ * @tparam N Number of options, deduced from the constructor argument.
+ */
+template <std::size_t N>
+class spec {
+public:
+  /**
+   * Creates the table.
+   *
+   * @param options The options, *without* the terminating entry.
+   * @throw std::invalid_argument if a short or long name is used twice or an
+   *        option has neither a short nor a long name.
+   */
+  constexpr spec(const nuts_getopts_option (&options)[N]) {
+    for (std::size_t i = 0; i < N; i++) {
+      const nuts_getopts_option& option = options_[i] = options[i];
+      std::int32_t ord = static_cast<std::int32_t>(i + 1);
+
+      if (option.sname == 0 && option.lname == nullptr)
+        throw std::invalid_argument("nuts::getopts::spec: option without a name");
+
+      if (option.sname != 0) {
+        std::int32_t& slot = shorts_[static_cast<unsigned char>(option.sname)];
+
+        if (slot != 0)
+          throw std::invalid_argument("nuts::getopts::spec: duplicate short name");
+
+        slot = ord;
+      }
+
+      if (option.lname != nullptr) {
+        names_[i] = option.lname;
+        hashes_[i] = detail::hash(names_[i]);
+
+        std::int32_t& slot = slots_[probe(names_[i], hashes_[i])];
+
+        if (slot != 0)
+          throw std::invalid_argument("nuts::getopts::spec: duplicate long name");
+
+        slot = ord;
+      }
+    }
+  }
+
+  /**
+   * Returns the options, terminated by an empty option. The array can be
+   * passed to nuts_getopts().
+   */
+  constexpr const nuts_getopts_option* options() const {
+    return options_;
+  }
+
+  /**
+   * Returns the number of options.
+   */
+  constexpr std::size_t size() const {
+    return N;
+  }
+
+  /**
+   * Returns the option with the short name `sname`, `nullptr` if there is no
+   * such option.
+   */
+  constexpr const nuts_getopts_option* find_short(char sname) const {
+    std::int32_t ord = shorts_[static_cast<unsigned char>(sname)];
+
+    return (ord != 0) ? &options_[ord - 1] : nullptr;
+  }
+
+  /**
+   * Returns the option with the long name `lname`, `nullptr` if there is no
+   * such option.
+   */
+  constexpr const nuts_getopts_option* find_long(std::string_view lname) const {
+    std::int32_t ord = slots_[probe(lname, detail::hash(lname))];
+
+    return (ord != 0) ? &options_[ord - 1] : nullptr;
+  }
+
+private:
+  static constexpr std::size_t lsize = detail::table_size(N);
+
+  // Returns the slot of lname, an empty slot if there is no such name.
+  constexpr std::size_t probe(std::string_view lname, std::uint32_t hash) const {
+    std::size_t idx = hash & (lsize - 1);
+    std::int32_t ord = 0;
+
+    while ((ord = slots_[idx]) != 0) {
+      if (hashes_[ord - 1] == hash && names_[ord - 1] == lname)
+        break;
+
+      idx = (idx + 1) & (lsize - 1);
+    }
+
+    return idx;
+  }
+
+  // The options, terminated by an empty option.
+  nuts_getopts_option options_[N + 1] = {};
+
+  // Ordinals (index + 1) of the short names, indexed by the character.
+  std::int32_t shorts_[256] = {};
+
+  // Long names and their hashes, indexed by the option.
+  std::string_view names_[N] = {};
+  std::uint32_t hashes_[N] = {};
+
+  // Open addressing hash table for long names, holds ordinals.
+  std::int32_t slots_[lsize] = {};
+};
+
+/** @cond SKIP_DOC */
+namespace detail {
+
+template <const auto& Spec>
+const nuts_getopts_option* find_short(char sname) {
+  return Spec.find_short(sname);
+}
+
+template <const auto& Spec>
+const nuts_getopts_option* find_long(const char* lname, int lname_len) {
+  return Spec.find_long(std::string_view(lname, lname_len));
+}
+
+}  // namespace detail
+/** @endcond */
+
+/**
+ * The lookup of a nuts::getopts::spec, which can be passed to
+ * nuts_getopts_lookup_parse().
+ *
+ * @tparam Spec A nuts::getopts::spec with static storage duration.
+ */
+template <const auto& Spec>
+inline constexpr nuts_getopts_lookup lookup = { &detail::find_short<Spec>, &detail::find_long<Spec> };
+
+/**
+ * A view of a nuts_getopts_event.
+ *
+ * The view is a pointer to the event, it is only valid until the parser
+ * emits the next event. The strings remain valid as long as the command line
+ * arguments resp. the parser state (for response files) exist.
+ */
+class event_view {
+public:
+  constexpr explicit event_view(const nuts_getopts_event& ev) : ev_(&ev) {}
+
+  /**
+   * Returns the type of the event.
+   */
+  constexpr nuts_getopts_event_type type() const {
+    return ev_->type;
+  }
+
+  /**
+   * Returns the string reported by the event: the tool name, the value of an
+   * option, the argument, the command name resp. the option of an error.
+   * Empty, if an option has no value.
+   */
+  constexpr std::string_view str() const {
+    switch (ev_->type) {
+      case nuts_getopts_tool_event:
+        return std::string_view(ev_->u.tool, ev_->len);
+      case nuts_getopts_option_event:
+        return (ev_->u.opt.value != nullptr) ? std::string_view(ev_->u.opt.value, ev_->len) : std::string_view();
+      case nuts_getopts_argument_event:
+        return std::string_view(ev_->u.arg, ev_->len);
+      case nuts_getopts_command_event:
+        return std::string_view(ev_->u.cmd->name, ev_->len);
+      case nuts_getopts_error_event:
+        return std::string_view(ev_->u.err.option, ev_->u.err.option_len);
+    }
+
+    return std::string_view();
+  }
+
+  /**
+   * Returns the option of a #nuts_getopts_option_event.
+   */
+  constexpr const nuts_getopts_option* option() const {
+    return ev_->u.opt.option;
+  }
+
+  /**
+   * Returns the converted value of a #nuts_getopts_option_event.
+   */
+  constexpr const nuts_getopts_typed& typed() const {
+    return ev_->u.opt.typed;
+  }
+
+  /**
+   * Returns the command of a #nuts_getopts_command_event.
+   */
+  constexpr const nuts_getopts_command* command() const {
+    return ev_->u.cmd;
+  }
+
+  /**
+   * Returns the error code of a #nuts_getopts_error_event.
+   */
+  constexpr nuts_getopts_error_type error() const {
+    return ev_->u.err.type;
+  }
+
+  /**
+   * Returns the underlying event.
+   */
+  constexpr const nuts_getopts_event& get() const {
+    return *ev_;
+  }
+
+private:
+  const nuts_getopts_event* ev_;
+};
+
+/**
+ * A parser run as an input range of nuts::getopts::event_view.
+ *
+ * Created by nuts::getopts::parse(). Each increment of the iterator invokes
+ * the parser once, the range owns the parser state and releases it on
+ * destruction.
+ *
+ * @tparam Parser Callable with the signature
+ *                `int(nuts_getopts_state*, nuts_getopts_event*)`, which
+ *                invokes one of the C parser functions.
+ */
+template <typename Parser>
+class events {
+public:
+  /** End of the range. */
+  struct sentinel {};
+
+  /** Input iterator over the events. */
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = event_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const event_view*;
+    using reference = event_view;
+
+    constexpr explicit iterator(events* range) : range_(range) {}
+
+    event_view operator*() const {
+      return event_view(range_->event_);
+    }
+
+    iterator& operator++() {
+      range_->next();
+      return *this;
+    }
+
+    void operator++(int) {
+      range_->next();
+    }
+
+    friend bool operator==(const iterator& it, sentinel) {
+      return it.done();
+    }
+
+    friend bool operator!=(const iterator& it, sentinel) {
+      return !it.done();
+    }
+
+    friend bool operator==(sentinel, const iterator& it) {
+      return it.done();
+    }
+
+    friend bool operator!=(sentinel, const iterator& it) {
+      return !it.done();
+    }
+
+  private:
+    bool done() const {
+      return range_->done_;
+    }
+
+    events* range_;
+  };
+
+  explicit events(Parser parser) : parser_(parser) {}
+
+  events(const events&) = delete;
+  events& operator=(const events&) = delete;
+
+  ~events() {
+    nuts_getopts_state_release(&state_);
+  }
+
+  /**
+   * Invokes the parser for the first event. The range can be iterated once.
+   */
+  iterator begin() {
+    next();
+    return iterator(this);
+  }
+
+  sentinel end() const {
+    return sentinel();
+  }
+
+private:
+  void next() {
+    done_ = parser_(&state_, &event_) != 0;
+  }
+
+  Parser parser_;
+  nuts_getopts_state state_ = {};
+  nuts_getopts_event event_ = {};
+  bool done_ = false;
+};
+
+/**
+ * Parses the command line with nuts_getopts().
+ */
+inline auto parse(int argc, char* argv[], const nuts_getopts_option* options, int flags = 0) {
+  return events([=](nuts_getopts_state* state, nuts_getopts_event* event) {
+    return nuts_getopts(argc, argv, options, flags, state, event);
+  });
+}
+
+/**
+ * Parses the command line with nuts_getopts_group().
+ */
+inline auto parse(int argc, char* argv[], const nuts_getopts_option_group* groups, int flags = 0) {
+  return events([=](nuts_getopts_state* state, nuts_getopts_event* event) {
+    return nuts_getopts_group(argc, argv, groups, flags, state, event);
+  });
+}
+
+/**
+ * Parses the command line with nuts_getopts_spec_parse().
+ */
+inline auto parse(int argc, char* argv[], const nuts_getopts_spec* spec, int flags = 0) {
+  return events([=](nuts_getopts_state* state, nuts_getopts_event* event) {
+    return nuts_getopts_spec_parse(argc, argv, spec, flags, state, event);
+  });
+}
+
+/**
+ * Parses the command line with nuts_getopts_lookup_parse(), e.g. with a
+ * nuts::getopts::lookup.
+ */
+inline auto parse(int argc, char* argv[], const nuts_getopts_lookup* lookup, int flags = 0) {
+  return events([=](nuts_getopts_state* state, nuts_getopts_event* event) {
+    return nuts_getopts_lookup_parse(argc, argv, lookup, flags, state, event);
+  });
+}
+
+/**
+ * Parses the command line with nuts_getopts_command_parse().
+ */
+inline auto parse(int argc, char* argv[], const nuts_getopts_spec* spec, const nuts_getopts_commands* commands, int flags = 0) {
+  return events([=](nuts_getopts_state* state, nuts_getopts_event* event) {
+    return nuts_getopts_command_parse(argc, argv, spec, commands, flags, state, event);
+  });
+}
+
+}  // namespace nuts::getopts
+
+#endif  /* NUTS_GETOPTS_HPP */
@@ -0,0 +1,129 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "private.h"
+
+// Minimum number of arguments handled by a thread.
+#define MIN_CHUNK_SIZE 4096
+
+// Upper limit of threads.
+#define MAX_THREADS 64
+
+struct chunk {
+  pthread_t thread;
+  int argc;
+  char** argv;
+  const struct resolver* resolver;
+  int flags;
+  int begin;
+  int end;
+  struct nuts_getopts_event* events;
+  int count;
+};
+
+static void* parse_chunk(void* arg) {
+  struct chunk* chunk = arg;
+
+  chunk->count = nuts_getopts_parse_range(chunk->argc, chunk->argv, chunk->resolver, chunk->flags, chunk->begin, chunk->end, chunk->events + chunk->begin);
+
+  return NULL;
+}
+
+static int num_threads(int argc, int nthreads) {
+  int max = (argc + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE;
+
+  if (nthreads <= 0) {
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    nthreads = (ncpus > 0) ? ncpus : 1;
+  }
+
+  if (nthreads > max)
+    nthreads = max;
+  if (nthreads > MAX_THREADS)
+    nthreads = MAX_THREADS;
+
+  return (nthreads > 0) ? nthreads : 1;
+}
+
+int nuts_getopts_parse_parallel(int argc, char* argv[], const nuts_getopts_spec* spec, int flags, int nthreads, struct nuts_getopts_event* events) {
+  const struct resolver resolver = { .spec = spec };
+  struct chunk chunks[MAX_THREADS];
+  int i, count, err = 0;
+
+  nthreads = num_threads(argc, nthreads);
+
+  // Response files are expanded sequentially, argv cannot be split.
+  flags &= ~nuts_getopts_response_files;
+
+  for (i = 0; i < nthreads; i++) {
+    struct chunk* chunk = &chunks[i];
+
+    chunk->argc = argc;
+    chunk->argv = argv;
+    chunk->resolver = &resolver;
+    chunk->flags = flags;
+    chunk->begin = (int)((long)argc * i / nthreads);
+    chunk->end = (int)((long)argc * (i + 1) / nthreads);
+    chunk->events = events;
+    chunk->count = 0;
+  }
+
+  // The calling thread parses the first chunk itself.
+  for (i = 1; i < nthreads; i++) {
+    if ((err = pthread_create(&chunks[i].thread, NULL, parse_chunk, &chunks[i])) != 0) {
+      nthreads = i;
+      break;
+    }
+  }
+
+  parse_chunk(&chunks[0]);
+
+  for (i = 1; i < nthreads; i++)
+    pthread_join(chunks[i].thread, NULL);
+
+  if (err != 0) {
+    errno = err;
+    return -1;
+  }
+
+  // Each chunk stored its events at the position of its first argument. Close
+  // the gaps left by ignored options, the order of the chunks is kept.
+  count = chunks[0].count;
+
+  for (i = 1; i < nthreads; i++) {
+    if (count != chunks[i].begin)
+      memmove(events + count, events + chunks[i].begin, chunks[i].count * sizeof(struct nuts_getopts_event));
+    count += chunks[i].count;
+  }
+
+  return count;
+}
@@ -0,0 +1,389 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#ifndef NUTS_GETOPTS_PRIVATE_H
+#define NUTS_GETOPTS_PRIVATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nuts-getopts.h"
+
+/*
+ * Internal interfaces shared between the translation units of the library.
+ * Nothing in here is part of the public API.
+ */
+
+/*
+ * Linkage of the internal symbols. In the single-header build they are local
+ * to the translation unit, which includes the implementation.
+ * NUTS_GETOPTS_INTERNAL is used for the functions, NUTS_GETOPTS_EXTERN resp.
+ * NUTS_GETOPTS_GLOBAL for the declaration resp. definition of a variable.
+ */
+#ifdef NUTS_GETOPTS_IMPLEMENTATION
+#define NUTS_GETOPTS_INTERNAL static inline
+#define NUTS_GETOPTS_EXTERN static
+#define NUTS_GETOPTS_GLOBAL static
+#else
+#define NUTS_GETOPTS_INTERNAL
+#define NUTS_GETOPTS_EXTERN extern
+#define NUTS_GETOPTS_GLOBAL
+#endif
+
+/*
+ * Allocates size zeroed bytes from arena, from the heap if arena is NULL.
+ * Sets errno to ENOMEM on failure.
+ */
+NUTS_GETOPTS_INTERNAL void* nuts_getopts_calloc(nuts_getopts_arena* arena, size_t size);
+
+/*
+ * Releases memory allocated by nuts_getopts_calloc(). A no-op for an arena.
+ */
+NUTS_GETOPTS_INTERNAL void nuts_getopts_free(nuts_getopts_arena* arena, void* ptr);
+
+/*
+ * Increments a counter of the instrumentation, if stats is attached. Compiled
+ * out unless NUTS_GETOPTS_STATS is defined.
+ */
+#ifdef NUTS_GETOPTS_STATS
+#define _stats_inc(stats, counter) do { if ((stats) != NULL) (stats)->counter++; } while (0)
+#else
+#define _stats_inc(stats, counter) do { } while (0)
+#endif
+
+/*
+ * Returns the current value of the cycle counter, see
+ * nuts_getopts_stats#cycles.
+ */
+NUTS_GETOPTS_INTERNAL uint64_t nuts_getopts_cycles(void);
+
+#define _group_eof(entry) (((entry)->group == NULL) && ((entry)->list == NULL))
+#define _list_eof(entry) (((entry)->sname == 0) && ((entry)->lname == NULL))
+
+/*
+ * A node of the trie over all long names. Node 0 is the root, 0 is also used
+ * as the "no node" link, since the root is never a child or sibling.
+ */
+struct trie_node {
+  unsigned char c;
+
+  /* First child and next sibling. */
+  int child;
+  int sibling;
+
+  /* Number of long names starting with the prefix represented by the node. */
+  int count;
+
+  /* Ordinal of an option starting with the prefix, the only one if count == 1. */
+  int option;
+
+  /* Ordinal of the option whose long name equals the prefix, 0 if none. */
+  int exact;
+};
+
+/*
+ * The compiled spec is a single allocation. Each option gets an ordinal
+ * (1 ... noptions) in tree order, 0 means "no option". The attributes of an
+ * option are stored in parallel arrays indexed by the ordinal, all long names
+ * are copied into a string pool. So a lookup touches a few dense arrays
+ * instead of chasing the pointers of the option tree.
+ */
+struct nuts_getopts_spec {
+  /* Ordinals of the short names, indexed by the (unsigned) character. */
+  int32_t shorts[256];
+
+  /* The arena the spec was allocated from, NULL for the heap. */
+  nuts_getopts_arena* arena;
+
+  int noptions;
+
+  /* The options passed by the caller, options[0] is NULL. */
+  const struct nuts_getopts_option** options;
+
+  /* Short names, 0 if the option has no short name. */
+  char* snames;
+
+  /* Length of the long names, -1 if the option has no long name. */
+  int32_t* lens;
+
+  /* Hashes of the long names. */
+  uint32_t* hashes;
+
+  /* Offsets of the NUL-terminated long names in pool. */
+  uint32_t* names;
+  char* pool;
+
+  /* Number of slots in lslots, always a power of two. */
+  uint32_t lsize;
+
+  /* Open addressing hash table for long names, holds ordinals. */
+  int32_t* lslots;
+
+  /* Open addressing hash table for the option pointers, holds ordinals. */
+  uint32_t psize;
+  int32_t* pslots;
+
+  /* Trie over all long names, used to resolve abbreviations. */
+  struct trie_node* trie;
+  int ntrie;
+};
+
+/*
+ * Option resolver used by the parser.
+ *
+ * If lookup is set, options are looked up by the generated functions. If spec
+ * is set, options are looked up in the compiled index, otherwise the
+ * groups-tree is traversed.
+ */
+struct resolver {
+  const struct nuts_getopts_option_group* groups;
+  const nuts_getopts_spec* spec;
+
+  /* Options of the selected command, looked up before spec. */
+  const nuts_getopts_spec* local;
+
+  /* If set, the first argument is looked up as a command. */
+  const nuts_getopts_commands* commands;
+
+  /* If set, options are looked up by the functions of a generated parser. */
+  const struct nuts_getopts_lookup* lookup;
+
+  /* Counters of an instrumented parser, NULL if not attached. */
+  struct nuts_getopts_stats* stats;
+};
+
+/*
+ * The recorded occurrences of an option.
+ */
+struct result_slot {
+  int count;
+
+  /*
+   * Range of the values of a multi-argument option in the values/lens arrays
+   * of the result.
+   */
+  int first;
+  int capacity;
+
+  /* The value of the last occurrence. */
+  const char* value;
+  int len;
+  union nuts_getopts_typed typed;
+};
+
+struct nuts_getopts_result {
+  const nuts_getopts_spec* spec;
+  nuts_getopts_arena* arena;
+
+  /* Presence bits, indexed by the ordinal of the option. */
+  uint64_t* bits;
+
+  /* Occurrences, indexed by the ordinal of the option. */
+  struct result_slot* slots;
+
+  /* Values of all multi-argument options, a single allocation. */
+  const char** values;
+  int* lens;
+
+  /* Set, when the values were reserved by nuts_getopts_result_prepare(). */
+  int prepared;
+};
+
+/*
+ * A node of the BK-tree over the long names of a spec. Node 0 is the root, 0
+ * is also used as the "no node" link, since the root is never a child or
+ * sibling.
+ */
+struct bk_node {
+  /* Ordinal of the option in the spec. */
+  int32_t ord;
+
+  /* Edit distance between the long names of the node and its parent. */
+  int32_t dist;
+
+  /* First child and next sibling. */
+  int32_t child;
+  int32_t sibling;
+};
+
+struct nuts_getopts_suggestions {
+  const nuts_getopts_spec* spec;
+  nuts_getopts_arena* arena;
+
+  /* Length of the longest long name. */
+  int max_len;
+
+  int nnodes;
+  struct bk_node* nodes;
+};
+
+/*
+ * A slot of the command table. An empty slot has command == NULL.
+ */
+struct nuts_getopts_command_entry {
+  uint32_t hash;
+  int len;
+  const struct nuts_getopts_command* command;
+
+  /*
+   * The compiled options of the command. For a command with a resolver it is
+   * set on first use, thus it must be accessed atomically.
+   */
+  nuts_getopts_spec* spec;
+};
+
+struct nuts_getopts_commands {
+  nuts_getopts_arena* arena;
+
+  /* Number of slots in slots, always a power of two. */
+  uint32_t size;
+
+  /* Open addressing hash table for command names. */
+  struct nuts_getopts_command_entry* slots;
+};
+
+/*
+ * Looks up the command name. Returns NULL if there is no such command.
+ */
+NUTS_GETOPTS_INTERNAL struct nuts_getopts_command_entry* nuts_getopts_commands_find(const nuts_getopts_commands* commands, const char* name, int len);
+
+/*
+ * Returns the compiled options of the command. If not compiled yet, the
+ * resolver of the command is called and its options are compiled. Returns
+ * NULL if the options cannot be resolved.
+ */
+NUTS_GETOPTS_INTERNAL const nuts_getopts_spec* nuts_getopts_command_resolve(const nuts_getopts_commands* commands, struct nuts_getopts_command_entry* entry);
+
+/*
+ * A command line argument to be parsed.
+ */
+struct token {
+  /* The argument, not necessarily NUL-terminated. */
+  const char* str;
+
+  /* Length of str. */
+  int len;
+
+  /* Position of the first '=' in str, -1 if there is none. */
+  int eq;
+};
+
+/*
+ * Scans the NUL-terminated token->str and fills token->len and token->eq in a
+ * single pass. The kernel is selected at runtime depending on the
+ * capabilities of the CPU.
+ */
+NUTS_GETOPTS_INTERNAL void nuts_getopts_scan(struct token* token);
+
+/*
+ * Returns the first blank (space, tab, newline), quote, backslash or the
+ * terminating NUL in str. Selected at runtime like nuts_getopts_scan.
+ */
+NUTS_GETOPTS_INTERNAL const char* nuts_getopts_scan_word(const char* str);
+
+/*
+ * Classifies a single token and creates the related event. Returns 1 if no
+ * event was created (the token was skipped), 0 otherwise.
+ */
+NUTS_GETOPTS_INTERNAL int nuts_getopts_on_token(const struct token* token, int is_tool, const struct resolver* resolver, int flags, struct nuts_getopts_event* event);
+
+/*
+ * A memory-mapped response file.
+ */
+struct nuts_getopts_response {
+  const char* addr;
+  size_t size;
+
+  /* Offset of the next token. */
+  size_t pos;
+
+  /* Nesting level, the outermost response file has level 1. */
+  int depth;
+
+  /* The enclosing response file, NULL for a response file found in argv. */
+  struct nuts_getopts_response* parent;
+
+  /* Next element in the list of all response files mapped by the parser. */
+  struct nuts_getopts_response* next;
+};
+
+/*
+ * Maps the response file referenced by token (@path) and makes it the current
+ * source of tokens. Returns -1 if the file cannot be mapped.
+ */
+NUTS_GETOPTS_INTERNAL int nuts_getopts_response_push(nuts_getopts_state* state, const struct token* token);
+
+/*
+ * Fetches the next token from the current response file. If the file is
+ * exhausted, the enclosing response file becomes current and -1 is returned.
+ */
+NUTS_GETOPTS_INTERNAL int nuts_getopts_response_next(nuts_getopts_state* state, struct token* token);
+
+/*
+ * Converts the option-argument str into type. Returns 0 on success or the
+ * nuts_getopts_error_type of the failure.
+ */
+NUTS_GETOPTS_INTERNAL int nuts_getopts_convert(nuts_getopts_value_type type, const char* str, int len, union nuts_getopts_typed* out);
+
+NUTS_GETOPTS_INTERNAL uint32_t nuts_getopts_hash(const char* str, int len);
+
+/*
+ * Returns the size of a hash table for n entries, a power of two.
+ */
+NUTS_GETOPTS_INTERNAL uint32_t nuts_getopts_table_size(int n);
+
+static inline const struct nuts_getopts_option* nuts_getopts_spec_find_short(const nuts_getopts_spec* spec, char sname) {
+  return spec->options[spec->shorts[(unsigned char)sname]];
+}
+
+NUTS_GETOPTS_INTERNAL const struct nuts_getopts_option* nuts_getopts_spec_find_long(const nuts_getopts_spec* spec, const char* lname, int lname_len);
+
+/*
+ * Returns the ordinal of option in spec, 0 if the option is not part of the
+ * spec.
+ */
+NUTS_GETOPTS_INTERNAL int nuts_getopts_spec_ordinal(const nuts_getopts_spec* spec, const struct nuts_getopts_option* option);
+
+/*
+ * Resolves a (possibly abbreviated) long name. Returns
+ * &nuts_getopts_ambiguous, if the abbreviation matches several options.
+ */
+NUTS_GETOPTS_INTERNAL const struct nuts_getopts_option* nuts_getopts_spec_find_prefix(const nuts_getopts_spec* spec, const char* lname, int lname_len);
+
+/* Marker for an ambiguous abbreviation. */
+NUTS_GETOPTS_EXTERN const struct nuts_getopts_option nuts_getopts_ambiguous;
+
+/*
+ * The parser loop shared by the public entry points.
+ */
+NUTS_GETOPTS_INTERNAL int nuts_getopts_parse(int argc, char* argv[], const struct resolver* resolver, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event);
+
+/*
+ * Parses the arguments argv[begin] ... argv[end - 1] and stores the events into
+ * events, which must have room for (end - begin) events. Returns the number of
+ * stored events.
+ */
+NUTS_GETOPTS_INTERNAL int nuts_getopts_parse_range(int argc, char* argv[], const struct resolver* resolver, int flags, int begin, int end, struct nuts_getopts_event* events);
+
+#endif  /* NUTS_GETOPTS_PRIVATE_H */
@@ -0,0 +1,165 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "private.h"
+
+// Maximum nesting level of response files.
+#define MAX_DEPTH 16
+
+// Maximum length of the path of a response file.
+#define MAX_PATH 4096
+
+static inline int is_space(char c) {
+  return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\v') || (c == '\f');
+}
+
+static const char* map_file(const char* path, size_t* size) {
+  struct stat st;
+  void* addr = NULL;
+  int fd;
+
+  if ((fd = open(path, O_RDONLY)) < 0)
+    return NULL;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    if (st.st_size > 0) {
+      addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (addr == MAP_FAILED)
+        addr = NULL;
+      else
+        *size = st.st_size;
+    } else {
+      // An empty file cannot be mapped but is still a valid response file.
+      addr = (void*)"";
+      *size = 0;
+    }
+  }
+
+  close(fd);
+
+  return addr;
+}
+
+int nuts_getopts_response_push(nuts_getopts_state* state, const struct token* token) {
+  struct nuts_getopts_response* response;
+  int depth = (state->response != NULL) ? state->response->depth + 1 : 1;
+  char path[MAX_PATH];
+  const char* addr;
+  size_t size;
+
+  // The token is not necessarily NUL-terminated, open(2) needs a copy of the
+  // path without the leading '@'.
+  if (depth > MAX_DEPTH || token->len > MAX_PATH)
+    return -1;
+
+  memcpy(path, token->str + 1, token->len - 1);
+  path[token->len - 1] = '\0';
+
+  if ((addr = map_file(path, &size)) == NULL)
+    return -1;
+
+  if ((response = nuts_getopts_calloc(state->arena, sizeof(struct nuts_getopts_response))) == NULL) {
+    if (size > 0)
+      munmap((void*)addr, size);
+    return -1;
+  }
+
+  response->addr = addr;
+  response->size = size;
+  response->pos = 0;
+  response->depth = depth;
+  response->parent = state->response;
+  response->next = state->responses;
+
+  state->response = response;
+  state->responses = response;
+
+  return 0;
+}
+
+int nuts_getopts_response_next(nuts_getopts_state* state, struct token* token) {
+  struct nuts_getopts_response* response = state->response;
+  const char* p = response->addr + response->pos;
+  const char* end = response->addr + response->size;
+  const char* eq = NULL;
+
+  while (p < end && is_space(*p))
+    p++;
+
+  if (p == end) {
+    // Exhausted, continue with the enclosing response file resp. argv. The
+    // mapping is kept, events still reference it.
+    state->response = response->parent;
+    return -1;
+  }
+
+  token->str = p;
+
+  for (; p < end && !is_space(*p); p++) {
+    if (*p == '=' && eq == NULL)
+      eq = p;
+  }
+
+  token->len = p - token->str;
+  token->eq = (eq != NULL) ? eq - token->str : -1;
+  response->pos = p - response->addr;
+
+  return 0;
+}
+
+void nuts_getopts_state_init(nuts_getopts_state* state, nuts_getopts_arena* arena) {
+  memset(state, 0, sizeof(nuts_getopts_state));
+  state->arena = arena;
+}
+
+void nuts_getopts_state_release(nuts_getopts_state* state) {
+  struct nuts_getopts_response* response = state->responses;
+
+  while (response != NULL) {
+    struct nuts_getopts_response* next = response->next;
+
+    if (response->size > 0)
+      munmap((void*)response->addr, response->size);
+    nuts_getopts_free(state->arena, response);
+
+    response = next;
+  }
+
+  // The arena and the instrumentation stay attached for the next run.
+  state->idx = 0;
+  state->response = NULL;
+  state->responses = NULL;
+  state->command = NULL;
+  state->command_done = 0;
+}
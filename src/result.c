@@ -0,0 +1,254 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <string.h>
+
+#include "private.h"
+
+static inline int nwords(const nuts_getopts_spec* spec) {
+  return spec->noptions / 64 + 1;
+}
+
+static inline const struct result_slot* find_slot(const nuts_getopts_result* result, const struct nuts_getopts_option* option) {
+  // An unknown option maps to ordinal 0, whose slot is never filled.
+  return &result->slots[nuts_getopts_spec_ordinal(result->spec, option)];
+}
+
+nuts_getopts_result* nuts_getopts_result_new(const nuts_getopts_spec* spec) {
+  return nuts_getopts_result_new_arena(spec, NULL);
+}
+
+nuts_getopts_result* nuts_getopts_result_new_arena(const nuts_getopts_spec* spec, nuts_getopts_arena* arena) {
+  // The bitset and the slots are placed behind the header.
+  size_t bits = sizeof(nuts_getopts_result);
+  size_t slots = bits + nwords(spec) * sizeof(uint64_t);
+  size_t len = slots + (spec->noptions + 1) * sizeof(struct result_slot);
+  nuts_getopts_result* result;
+  char* block;
+
+  if ((block = nuts_getopts_calloc(arena, len)) == NULL)
+    return NULL;
+
+  result = (nuts_getopts_result*)block;
+  result->spec = spec;
+  result->arena = arena;
+  result->bits = (uint64_t*)(block + bits);
+  result->slots = (struct result_slot*)(block + slots);
+
+  return result;
+}
+
+void nuts_getopts_result_free(nuts_getopts_result* result) {
+  if (result != NULL) {
+    nuts_getopts_free(result->arena, result->values);
+    nuts_getopts_free(result->arena, result);
+  }
+}
+
+void nuts_getopts_result_clear(nuts_getopts_result* result) {
+  memset(result->bits, 0, nwords(result->spec) * sizeof(uint64_t));
+  memset(result->slots, 0, (result->spec->noptions + 1) * sizeof(struct result_slot));
+
+  nuts_getopts_free(result->arena, result->values);
+  result->values = NULL;
+  result->lens = NULL;
+  result->prepared = 0;
+}
+
+// Returns the option named by token, NULL if token is not a known option.
+static const struct nuts_getopts_option* classify(const nuts_getopts_spec* spec, const struct token* token, int flags) {
+  const struct nuts_getopts_option* option;
+
+  if (token->len > 2 && token->str[0] == '-' && token->str[1] == '-') {
+    int name_len = ((token->eq >= 0) ? token->eq : token->len) - 2;
+
+    if ((flags & nuts_getopts_allow_abbreviations) > 0)
+      option = nuts_getopts_spec_find_prefix(spec, token->str + 2, name_len);
+    else
+      option = nuts_getopts_spec_find_long(spec, token->str + 2, name_len);
+
+    return (option != &nuts_getopts_ambiguous) ? option : NULL;
+  } else if (token->len > 1 && token->str[0] == '-') {
+    return nuts_getopts_spec_find_short(spec, token->str[1]);
+  } else {
+    return NULL;
+  }
+}
+
+// Counts the multi-argument options by the full parser, which expands the
+// response files.
+static void count_parsed(nuts_getopts_result* result, int argc, char* argv[], int flags) {
+  const struct resolver resolver = { .spec = result->spec };
+  nuts_getopts_state state = { 0 };
+  struct nuts_getopts_event event;
+
+  // Only options are of interest for counting.
+  flags |= nuts_getopts_skip_tool | nuts_getopts_skip_arguments;
+
+  while (nuts_getopts_parse(argc, argv, &resolver, flags, &state, &event) == 0) {
+    if (event.type == nuts_getopts_option_event && event.u.opt.option->arg == nuts_getopts_multi_argument)
+      result->slots[nuts_getopts_spec_ordinal(result->spec, event.u.opt.option)].capacity++;
+  }
+
+  nuts_getopts_state_release(&state);
+}
+
+int nuts_getopts_result_prepare(nuts_getopts_result* result, int argc, char* argv[], int flags) {
+  const nuts_getopts_spec* spec = result->spec;
+  int total = 0, ord, i;
+
+  for (ord = 0; ord <= spec->noptions; ord++)
+    result->slots[ord].capacity = 0;
+
+  // The arguments are only scanned and looked up, values are not converted.
+  // An option with a missing value is counted as well, reserving a slot too
+  // many does no harm.
+  for (i = 1; i < argc; i++) {
+    struct token token = { .str = argv[i] };
+    const struct nuts_getopts_option* option;
+
+    nuts_getopts_scan(&token);
+
+    // The options of a response file are only known by reading the file.
+    if ((flags & nuts_getopts_response_files) > 0 && token.len > 1 && token.str[0] == '@') {
+      for (ord = 0; ord <= spec->noptions; ord++)
+        result->slots[ord].capacity = 0;
+
+      count_parsed(result, argc, argv, flags);
+      break;
+    }
+
+    if ((option = classify(spec, &token, flags)) != NULL && option->arg == nuts_getopts_multi_argument)
+      result->slots[nuts_getopts_spec_ordinal(spec, option)].capacity++;
+  }
+
+  for (ord = 0; ord <= result->spec->noptions; ord++) {
+    result->slots[ord].first = total;
+    total += result->slots[ord].capacity;
+  }
+
+  nuts_getopts_free(result->arena, result->values);
+  result->values = NULL;
+  result->lens = NULL;
+
+  // The values of all options share one allocation, the lengths follow the
+  // pointers.
+  if (total > 0) {
+    if ((result->values = nuts_getopts_calloc(result->arena, total * (sizeof(const char*) + sizeof(int)))) == NULL) {
+      // Continue without collecting the values.
+      for (ord = 0; ord <= result->spec->noptions; ord++)
+        result->slots[ord].capacity = 0;
+
+      result->prepared = 1;
+      return -1;
+    }
+
+    result->lens = (int*)(result->values + total);
+  }
+
+  result->prepared = 1;
+
+  return 0;
+}
+
+int nuts_getopts_result_record(nuts_getopts_result* result, const struct nuts_getopts_event* event) {
+  struct result_slot* slot;
+  int ord;
+
+  if (event->type != nuts_getopts_option_event)
+    return -1;
+
+  if ((ord = nuts_getopts_spec_ordinal(result->spec, event->u.opt.option)) == 0)
+    return -1;
+
+  result->bits[ord / 64] |= (uint64_t)1 << (ord % 64);
+
+  slot = &result->slots[ord];
+
+  if (slot->count < slot->capacity) {
+    result->values[slot->first + slot->count] = event->u.opt.value;
+    result->lens[slot->first + slot->count] = event->len;
+  }
+
+  slot->count++;
+  slot->value = event->u.opt.value;
+  slot->len = event->len;
+  slot->typed = event->u.opt.typed;
+
+  return 0;
+}
+
+int nuts_getopts_result_parse(int argc, char* argv[], nuts_getopts_result* result, int flags, nuts_getopts_state* state, struct nuts_getopts_event* event) {
+  const struct resolver resolver = { .spec = result->spec };
+
+  if (!result->prepared && nuts_getopts_result_prepare(result, argc, argv, flags) != 0) {
+    memset(event, 0, sizeof(struct nuts_getopts_event));
+    event->type = nuts_getopts_error_event;
+    event->u.err.type = nuts_getopts_out_of_memory;
+    return 0;
+  }
+
+  while (nuts_getopts_parse(argc, argv, &resolver, flags, state, event) == 0) {
+    // Options are recorded, all other events are reported.
+    if (nuts_getopts_result_record(result, event) != 0)
+      return 0;
+  }
+
+  return -1;
+}
+
+int nuts_getopts_is_set(const nuts_getopts_result* result, const struct nuts_getopts_option* option) {
+  int ord = nuts_getopts_spec_ordinal(result->spec, option);
+
+  return (result->bits[ord / 64] >> (ord % 64)) & 1;
+}
+
+int nuts_getopts_count(const nuts_getopts_result* result, const struct nuts_getopts_option* option) {
+  return find_slot(result, option)->count;
+}
+
+const char* nuts_getopts_value(const nuts_getopts_result* result, const struct nuts_getopts_option* option) {
+  return find_slot(result, option)->value;
+}
+
+int nuts_getopts_value_len(const nuts_getopts_result* result, const struct nuts_getopts_option* option) {
+  return find_slot(result, option)->len;
+}
+
+const char* const* nuts_getopts_values(const nuts_getopts_result* result, const struct nuts_getopts_option* option, const int** lens) {
+  const struct result_slot* slot = find_slot(result, option);
+
+  // The array is incomplete, if the command line was not prepared.
+  if (slot->count == 0 || slot->count > slot->capacity)
+    return NULL;
+
+  if (lens != NULL)
+    *lens = result->lens + slot->first;
+
+  return result->values + slot->first;
+}
+
+union nuts_getopts_typed nuts_getopts_typed_value(const nuts_getopts_result* result, const struct nuts_getopts_option* option) {
+  return find_slot(result, option)->typed;
+}
@@ -0,0 +1,261 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "private.h"
+
+// The vector kernels read aligned blocks past the terminating NUL. That never
+// crosses a page, but the address sanitizers report it, sanitized builds use
+// the scalar kernels.
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_HWADDRESS__)
+#define SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(hwaddress_sanitizer)
+#define SANITIZED 1
+#endif
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SANITIZED)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+ * All kernels scan a NUL-terminated string for its terminating NUL and for the
+ * first '=' in front of it. The result is stored in token->len resp.
+ * token->eq.
+ *
+ * The vectorized kernels use aligned loads only. An aligned load never crosses
+ * a page boundary, thus it cannot fault even if it reads past the terminating
+ * NUL.
+ */
+
+static void scan_scalar(struct token* token) {
+  const char* str = token->str;
+  const char* p = str;
+
+  token->eq = -1;
+
+  for (; *p != '\0'; p++) {
+    if (*p == '=') {
+      token->eq = p - str;
+      break;
+    }
+  }
+
+  for (; *p != '\0'; p++);
+
+  token->len = p - str;
+}
+
+#ifdef HAVE_X86_SIMD
+
+static inline int first_bit(uint32_t mask) {
+  return __builtin_ctz(mask);
+}
+
+__attribute__((target("sse2")))
+static void scan_sse2(struct token* token) {
+  const char* str = token->str;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i eq = _mm_set1_epi8('=');
+  int offs = (uintptr_t)str & 15;
+  const char* p = str - offs;
+  uint32_t skip = ~((1u << offs) - 1) & 0xFFFF;
+
+  token->eq = -1;
+
+  for (;; p += 16, skip = 0xFFFF) {
+    __m128i chunk = _mm_load_si128((const __m128i*)p);
+    uint32_t nul_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)) & skip;
+    uint32_t eq_mask = 0;
+
+    if (token->eq < 0)
+      eq_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, eq)) & skip;
+
+    if (nul_mask != 0) {
+      // Only a '=' in front of the NUL counts.
+      eq_mask &= (1u << first_bit(nul_mask)) - 1;
+
+      if (eq_mask != 0)
+        token->eq = p + first_bit(eq_mask) - str;
+
+      token->len = p + first_bit(nul_mask) - str;
+      return;
+    }
+
+    if (eq_mask != 0)
+      token->eq = p + first_bit(eq_mask) - str;
+  }
+}
+
+__attribute__((target("avx2")))
+static void scan_avx2(struct token* token) {
+  const char* str = token->str;
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i eq = _mm256_set1_epi8('=');
+  int offs = (uintptr_t)str & 31;
+  const char* p = str - offs;
+  uint32_t skip = ~(uint32_t)((1ull << offs) - 1);
+
+  token->eq = -1;
+
+  for (;; p += 32, skip = 0xFFFFFFFF) {
+    __m256i chunk = _mm256_load_si256((const __m256i*)p);
+    uint32_t nul_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero)) & skip;
+    uint32_t eq_mask = 0;
+
+    if (token->eq < 0)
+      eq_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, eq)) & skip;
+
+    if (nul_mask != 0) {
+      eq_mask &= (uint32_t)((1ull << first_bit(nul_mask)) - 1);
+
+      if (eq_mask != 0)
+        token->eq = p + first_bit(eq_mask) - str;
+
+      token->len = p + first_bit(nul_mask) - str;
+      return;
+    }
+
+    if (eq_mask != 0)
+      token->eq = p + first_bit(eq_mask) - str;
+  }
+}
+
+#endif  /* HAVE_X86_SIMD */
+
+/*
+ * The word kernels return the first character in str, which is special for
+ * the shell-style tokenizer: a blank, a quote, a backslash or the
+ * terminating NUL.
+ */
+
+static inline int is_special(char c) {
+  return c == '\0' || c == ' ' || c == '\t' || c == '\n' || c == '\'' || c == '"' || c == '\\';
+}
+
+static const char* word_scalar(const char* str) {
+  while (!is_special(*str))
+    str++;
+
+  return str;
+}
+
+#ifdef HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static const char* word_sse2(const char* str) {
+  const char specials[] = { '\0', ' ', '\t', '\n', '\'', '"', '\\' };
+  int offs = (uintptr_t)str & 15;
+  const char* p = str - offs;
+  uint32_t skip = ~((1u << offs) - 1) & 0xFFFF;
+
+  for (;; p += 16, skip = 0xFFFF) {
+    __m128i chunk = _mm_load_si128((const __m128i*)p);
+    __m128i hits = _mm_setzero_si128();
+    uint32_t mask;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(specials); i++)
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(specials[i])));
+
+    if ((mask = _mm_movemask_epi8(hits) & skip) != 0)
+      return p + first_bit(mask);
+  }
+}
+
+__attribute__((target("avx2")))
+static const char* word_avx2(const char* str) {
+  const char specials[] = { '\0', ' ', '\t', '\n', '\'', '"', '\\' };
+  int offs = (uintptr_t)str & 31;
+  const char* p = str - offs;
+  uint32_t skip = ~(uint32_t)((1ull << offs) - 1);
+
+  for (;; p += 32, skip = 0xFFFFFFFF) {
+    __m256i chunk = _mm256_load_si256((const __m256i*)p);
+    __m256i hits = _mm256_setzero_si256();
+    uint32_t mask;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(specials); i++)
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(specials[i])));
+
+    if ((mask = (uint32_t)_mm256_movemask_epi8(hits) & skip) != 0)
+      return p + first_bit(mask);
+  }
+}
+
+#endif  /* HAVE_X86_SIMD */
+
+static const char* word_select(const char* str);
+static void scan_select(struct token* token);
+
+// The selected kernels. Concurrent callers may select at the same time, the
+// pointers are therefore only accessed atomically.
+static const char* (*word_kernel)(const char* str) = word_select;
+static void (*scan_kernel)(struct token* token) = scan_select;
+
+static const char* word_select(const char* str) {
+  const char* (*kernel)(const char*) = word_scalar;
+
+#ifdef HAVE_X86_SIMD
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    kernel = word_avx2;
+  else if (__builtin_cpu_supports("sse2"))
+    kernel = word_sse2;
+#endif
+
+  __atomic_store_n(&word_kernel, kernel, __ATOMIC_RELAXED);
+
+  return kernel(str);
+}
+
+static void scan_select(struct token* token) {
+  void (*kernel)(struct token*) = scan_scalar;
+
+#ifdef HAVE_X86_SIMD
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    kernel = scan_avx2;
+  else if (__builtin_cpu_supports("sse2"))
+    kernel = scan_sse2;
+#endif
+
+  __atomic_store_n(&scan_kernel, kernel, __ATOMIC_RELAXED);
+  kernel(token);
+}
+
+const char* nuts_getopts_scan_word(const char* str) {
+  return __atomic_load_n(&word_kernel, __ATOMIC_RELAXED)(str);
+}
+
+void nuts_getopts_scan(struct token* token) {
+  __atomic_load_n(&scan_kernel, __ATOMIC_RELAXED)(token);
+}
@@ -0,0 +1,130 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "private.h"
+
+// Keeps the reader counters on separate cache lines.
+#define CACHE_LINE_SIZE 64
+
+/*
+ * Readers announce themselves in one of two counters, selected by the parity
+ * of gen. A writer publishes the new spec, then flips gen twice and each time
+ * waits for the counter of the previous parity to drain. A reader, which
+ * could still see the old spec, registered before the new spec was published
+ * and is therefore covered by one of the two waits. Flipping gen directs new
+ * readers to the other counter, so a writer is not starved by a steady stream
+ * of readers.
+ */
+struct nuts_getopts_shared {
+  nuts_getopts_spec* current;
+  unsigned int gen;
+  char pad[CACHE_LINE_SIZE];
+
+  struct {
+    long count;
+    char pad[CACHE_LINE_SIZE - sizeof(long)];
+  } readers[2];
+
+  /* Serializes the writers. */
+  pthread_mutex_t mutex;
+
+  nuts_getopts_arena* arena;
+};
+
+static void wait_for_readers(nuts_getopts_shared* shared) {
+  unsigned int gen = __atomic_fetch_add(&shared->gen, 1, __ATOMIC_SEQ_CST);
+
+  while (__atomic_load_n(&shared->readers[gen & 1].count, __ATOMIC_SEQ_CST) != 0)
+    sched_yield();
+}
+
+nuts_getopts_shared* nuts_getopts_shared_new(nuts_getopts_spec* spec) {
+  return nuts_getopts_shared_new_arena(spec, NULL);
+}
+
+nuts_getopts_shared* nuts_getopts_shared_new_arena(nuts_getopts_spec* spec, nuts_getopts_arena* arena) {
+  nuts_getopts_shared* shared;
+
+  if ((shared = nuts_getopts_calloc(arena, sizeof(nuts_getopts_shared))) == NULL)
+    return NULL;
+
+  if ((errno = pthread_mutex_init(&shared->mutex, NULL)) != 0) {
+    nuts_getopts_free(arena, shared);
+    return NULL;
+  }
+
+  shared->current = spec;
+  shared->arena = arena;
+
+  return shared;
+}
+
+void nuts_getopts_shared_free(nuts_getopts_shared* shared) {
+  if (shared != NULL) {
+    nuts_getopts_spec_free(shared->current);
+    pthread_mutex_destroy(&shared->mutex);
+    nuts_getopts_free(shared->arena, shared);
+  }
+}
+
+const nuts_getopts_spec* nuts_getopts_shared_acquire(nuts_getopts_shared* shared, int* ticket) {
+  for (;;) {
+    unsigned int gen = __atomic_load_n(&shared->gen, __ATOMIC_SEQ_CST);
+
+    __atomic_add_fetch(&shared->readers[gen & 1].count, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&shared->gen, __ATOMIC_SEQ_CST) == gen) {
+      *ticket = gen & 1;
+      return __atomic_load_n(&shared->current, __ATOMIC_SEQ_CST);
+    }
+
+    // A writer flipped the counters in the meantime, use the new one.
+    __atomic_sub_fetch(&shared->readers[gen & 1].count, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+void nuts_getopts_shared_release(nuts_getopts_shared* shared, int ticket) {
+  __atomic_sub_fetch(&shared->readers[ticket].count, 1, __ATOMIC_SEQ_CST);
+}
+
+nuts_getopts_spec* nuts_getopts_shared_swap(nuts_getopts_shared* shared, nuts_getopts_spec* spec) {
+  nuts_getopts_spec* old;
+
+  pthread_mutex_lock(&shared->mutex);
+
+  old = __atomic_exchange_n(&shared->current, spec, __ATOMIC_SEQ_CST);
+
+  wait_for_readers(shared);
+  wait_for_readers(shared);
+
+  pthread_mutex_unlock(&shared->mutex);
+
+  return old;
+}
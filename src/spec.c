@@ -0,0 +1,312 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <errno.h>
+#include <string.h>
+
+#include "private.h"
+
+static void count_options(const struct nuts_getopts_option_group* groups, int* noptions, int* nbytes) {
+  const struct nuts_getopts_option_group* entry = groups;
+
+  while (!_group_eof(entry)) {
+    if (entry->group != NULL)
+      count_options(entry->group, noptions, nbytes);
+
+    if (entry->list != NULL) {
+      const struct nuts_getopts_option* option = entry->list;
+
+      while (!_list_eof(option)) {
+        (*noptions)++;
+
+        if (option->lname != NULL)
+          (*nbytes) += strlen(option->lname) + 1;
+
+        option++;
+      }
+    }
+
+    entry++;
+  }
+}
+
+static int32_t* probe(const nuts_getopts_spec* spec, uint32_t hash, const char* name, int len) {
+  uint32_t idx = hash & (spec->lsize - 1);
+  int32_t ord;
+
+  while ((ord = spec->lslots[idx]) != 0) {
+    if (spec->hashes[ord] == hash && spec->lens[ord] == len && memcmp(spec->pool + spec->names[ord], name, len) == 0)
+      break;
+
+    idx = (idx + 1) & (spec->lsize - 1);
+  }
+
+  return &spec->lslots[idx];
+}
+
+static int32_t* probe_pointer(const nuts_getopts_spec* spec, const struct nuts_getopts_option* option) {
+  // Fibonacci hashing, the low bits of a pointer are always zero.
+  uint32_t hash = (uint32_t)(((uintptr_t)option >> 3) * 2654435769u);
+  uint32_t idx = hash & (spec->psize - 1);
+  int32_t ord;
+
+  while ((ord = spec->pslots[idx]) != 0 && spec->options[ord] != option)
+    idx = (idx + 1) & (spec->psize - 1);
+
+  return &spec->pslots[idx];
+}
+
+static int trie_child(const nuts_getopts_spec* spec, int node, unsigned char c) {
+  int child;
+
+  for (child = spec->trie[node].child; child != 0; child = spec->trie[child].sibling) {
+    if (spec->trie[child].c == c)
+      return child;
+  }
+
+  return 0;
+}
+
+static void trie_insert(nuts_getopts_spec* spec, const char* name, int len, int ord) {
+  int node = 0, i;
+
+  for (i = 0; i < len; i++) {
+    unsigned char c = name[i];
+    int child = trie_child(spec, node, c);
+
+    if (child == 0) {
+      struct trie_node* new_node = &spec->trie[child = spec->ntrie++];
+
+      new_node->c = c;
+      new_node->sibling = spec->trie[node].child;
+      spec->trie[node].child = child;
+    }
+
+    node = child;
+    spec->trie[node].count++;
+
+    if (spec->trie[node].option == 0)
+      spec->trie[node].option = ord;
+  }
+
+  spec->trie[node].exact = ord;
+}
+
+static int insert_short(nuts_getopts_spec* spec, int ord) {
+  int32_t* slot = &spec->shorts[(unsigned char)spec->snames[ord]];
+
+  if (*slot != 0)
+    return -1;
+
+  *slot = ord;
+
+  return 0;
+}
+
+static int insert_long(nuts_getopts_spec* spec, int ord, uint32_t* pool_len) {
+  const char* lname = spec->options[ord]->lname;
+  int len = strlen(lname);
+  uint32_t hash = nuts_getopts_hash(lname, len);
+  int32_t* slot = probe(spec, hash, lname, len);
+
+  if (*slot != 0)
+    return -1;
+
+  // Copy the name into the pool, the slot is matched against the copy.
+  spec->names[ord] = *pool_len;
+  memcpy(spec->pool + *pool_len, lname, len + 1);
+  *pool_len += len + 1;
+
+  spec->hashes[ord] = hash;
+  spec->lens[ord] = len;
+  *slot = ord;
+
+  trie_insert(spec, lname, len, ord);
+
+  return 0;
+}
+
+static int index_options(nuts_getopts_spec* spec, const struct nuts_getopts_option_group* groups, uint32_t* pool_len) {
+  const struct nuts_getopts_option_group* entry = groups;
+
+  while (!_group_eof(entry)) {
+    if (entry->group != NULL && index_options(spec, entry->group, pool_len) != 0)
+      return -1;
+
+    if (entry->list != NULL) {
+      const struct nuts_getopts_option* option = entry->list;
+
+      while (!_list_eof(option)) {
+        int ord = ++spec->noptions;
+
+        spec->options[ord] = option;
+        spec->snames[ord] = option->sname;
+        spec->lens[ord] = -1;
+        *probe_pointer(spec, option) = ord;
+
+        if (option->sname != 0 && insert_short(spec, ord) != 0)
+          return -1;
+        if (option->lname != NULL && insert_long(spec, ord, pool_len) != 0)
+          return -1;
+        option++;
+      }
+    }
+
+    entry++;
+  }
+
+  return 0;
+}
+
+// Reserves count elements of size bytes in a block of *len bytes.
+static size_t carve(size_t* len, size_t count, size_t size) {
+  size_t offset = *len;
+
+  *len += count * size;
+
+  return offset;
+}
+
+NUTS_GETOPTS_GLOBAL const struct nuts_getopts_option nuts_getopts_ambiguous = { 0 };
+
+uint32_t nuts_getopts_table_size(int n) {
+  uint32_t size = 8;
+
+  // Keep the load factor below 50%
+  while (size < (uint32_t)n * 2)
+    size <<= 1;
+
+  return size;
+}
+
+uint32_t nuts_getopts_hash(const char* str, int len) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    hash ^= (unsigned char)str[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+const struct nuts_getopts_option* nuts_getopts_spec_find_long(const nuts_getopts_spec* spec, const char* lname, int lname_len) {
+  uint32_t hash = nuts_getopts_hash(lname, lname_len);
+
+  return spec->options[*probe(spec, hash, lname, lname_len)];
+}
+
+int nuts_getopts_spec_ordinal(const nuts_getopts_spec* spec, const struct nuts_getopts_option* option) {
+  return *probe_pointer(spec, option);
+}
+
+const struct nuts_getopts_option* nuts_getopts_spec_find_prefix(const nuts_getopts_spec* spec, const char* lname, int lname_len) {
+  const struct trie_node* node;
+  int idx = 0, i;
+
+  // An empty name (--=value) is no abbreviation of anything, it must not end
+  // up at the root, which is the prefix of all names.
+  if (lname_len == 0)
+    return NULL;
+
+  for (i = 0; i < lname_len; i++) {
+    if ((idx = trie_child(spec, idx, lname[i])) == 0)
+      return NULL;
+  }
+
+  node = &spec->trie[idx];
+
+  // An exact match wins over longer names sharing the prefix.
+  if (node->exact != 0)
+    return spec->options[node->exact];
+  else if (node->count == 1)
+    return spec->options[node->option];
+  else
+    return &nuts_getopts_ambiguous;
+}
+
+nuts_getopts_spec* nuts_getopts_compile(const struct nuts_getopts_option_group* groups) {
+  return nuts_getopts_compile_arena(groups, NULL);
+}
+
+nuts_getopts_spec* nuts_getopts_compile_arena(const struct nuts_getopts_option_group* groups, nuts_getopts_arena* arena) {
+  nuts_getopts_spec* spec;
+  int noptions = 0, nbytes = 0;
+  size_t len = sizeof(nuts_getopts_spec);
+  size_t options, trie, lens, hashes, names, lslots, pslots, snames, pool;
+  uint32_t lsize, psize, pool_len = 0;
+  char* block;
+
+  if (groups != NULL)
+    count_options(groups, &noptions, &nbytes);
+
+  lsize = nuts_getopts_table_size(noptions);
+  psize = nuts_getopts_table_size(noptions);
+
+  // The arrays are placed by decreasing alignment behind the header, so no
+  // padding is required. Each byte of a long name creates at most one trie
+  // node, node 0 is the root.
+  options = carve(&len, noptions + 1, sizeof(struct nuts_getopts_option*));
+  trie = carve(&len, nbytes + 1, sizeof(struct trie_node));
+  lens = carve(&len, noptions + 1, sizeof(int32_t));
+  hashes = carve(&len, noptions + 1, sizeof(uint32_t));
+  names = carve(&len, noptions + 1, sizeof(uint32_t));
+  lslots = carve(&len, lsize, sizeof(int32_t));
+  pslots = carve(&len, psize, sizeof(int32_t));
+  snames = carve(&len, noptions + 1, sizeof(char));
+  pool = carve(&len, nbytes, sizeof(char));
+
+  if ((block = nuts_getopts_calloc(arena, len)) == NULL)
+    return NULL;
+
+  spec = (nuts_getopts_spec*)block;
+  spec->arena = arena;
+  spec->options = (const struct nuts_getopts_option**)(block + options);
+  spec->trie = (struct trie_node*)(block + trie);
+  spec->ntrie = 1;
+  spec->lens = (int32_t*)(block + lens);
+  spec->hashes = (uint32_t*)(block + hashes);
+  spec->names = (uint32_t*)(block + names);
+  spec->lsize = lsize;
+  spec->lslots = (int32_t*)(block + lslots);
+  spec->psize = psize;
+  spec->pslots = (int32_t*)(block + pslots);
+  spec->snames = block + snames;
+  spec->pool = block + pool;
+
+  if (groups != NULL && index_options(spec, groups, &pool_len) != 0) {
+    nuts_getopts_spec_free(spec);
+    errno = EEXIST;
+    return NULL;
+  }
+
+  return spec;
+}
+
+void nuts_getopts_spec_free(nuts_getopts_spec* spec) {
+  if (spec != NULL)
+    nuts_getopts_free(spec->arena, spec);
+}
@@ -0,0 +1,159 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <errno.h>
+#include <string.h>
+
+#include "private.h"
+
+static inline int is_blank(char c) {
+  return c == ' ' || c == '\t' || c == '\n';
+}
+
+static inline int is_dquote_escape(char c) {
+  return c == '$' || c == '`' || c == '"' || c == '\\' || c == '\n';
+}
+
+// Moves the n characters at src to dst. Nothing is moved as long as nothing
+// was unescaped, since dst == src.
+static inline char* copy(char* dst, const char* src, size_t n) {
+  if (dst != src)
+    memmove(dst, src, n);
+
+  return dst + n;
+}
+
+/*
+ * Splits the word starting at *src. The unquoted and unescaped characters are
+ * written to *dst, which never runs ahead of *src. Returns -1 on a missing
+ * closing quote or a trailing backslash.
+ */
+static int split_word(char** src, char** dst) {
+  char* r = *src;
+  char* w = *dst;
+
+  for (;;) {
+    size_t n = nuts_getopts_scan_word(r) - r;
+    char* q;
+
+    w = copy(w, r, n);
+    r += n;
+
+    switch (*r) {
+      case '\0':
+        *src = r;
+        *dst = w;
+        return 0;
+
+      case ' ':
+      case '\t':
+      case '\n':
+        *src = r + 1;
+        *dst = w;
+        return 0;
+
+      case '\\':
+        if (r[1] == '\0')
+          return -1;
+        else if (r[1] != '\n')  // A backslash-newline is removed entirely
+          *w++ = r[1];
+        r += 2;
+        break;
+
+      case '\'':
+        if ((q = strchr(r + 1, '\'')) == NULL)
+          return -1;
+
+        w = copy(w, r + 1, q - r - 1);
+        r = q + 1;
+        break;
+
+      case '"':
+        for (r++; (q = strpbrk(r, "\"\\")) != NULL && *q == '\\'; ) {
+          w = copy(w, r, q - r);
+
+          // Inside double quotes a backslash only escapes some characters,
+          // otherwise it is kept.
+          if (q[1] == '\0')
+            return -1;
+
+          if (!is_dquote_escape(q[1])) {
+            *w++ = '\\';
+            r = q + 1;
+          } else {
+            if (q[1] != '\n')
+              *w++ = q[1];
+            r = q + 2;
+          }
+        }
+
+        if (q == NULL)
+          return -1;
+
+        w = copy(w, r, q - r);
+        r = q + 1;
+        break;
+    }
+  }
+}
+
+int nuts_getopts_split(char* buf, char* argv[], int size) {
+  char* src = buf;
+  char* dst = buf;
+  int argc = 0;
+
+  for (;;) {
+    // Skip blanks and line continuations between the words.
+    while (is_blank(*src) || (src[0] == '\\' && src[1] == '\n'))
+      src += (*src == '\\') ? 2 : 1;
+
+    if (*src == '\0')
+      break;
+
+    // Keep one element for the terminating NULL pointer.
+    if (argc + 1 >= size) {
+      errno = E2BIG;
+      return -1;
+    }
+
+    argv[argc++] = dst;
+
+    if (split_word(&src, &dst) != 0) {
+      errno = EINVAL;
+      return -1;
+    }
+
+    // dst is behind src, so the terminator never overwrites unread input.
+    *dst++ = '\0';
+  }
+
+  if (size < 1) {
+    errno = E2BIG;
+    return -1;
+  }
+
+  argv[argc] = NULL;
+
+  return argc;
+}
@@ -0,0 +1,215 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "private.h"
+
+static long read_fd(void* ctx, char* buf, size_t len) {
+  int fd = *(int*)ctx;
+  long nread;
+
+  do {
+    nread = read(fd, buf, len);
+  } while (nread < 0 && errno == EINTR);
+
+  return nread;
+}
+
+void nuts_getopts_stream_init(nuts_getopts_stream* stream, long (*read)(void* ctx, char* buf, size_t len), void* ctx, char delim, char* buf, size_t size) {
+  memset(stream, 0, sizeof(nuts_getopts_stream));
+
+  stream->read = read;
+  stream->ctx = ctx;
+  stream->delim = delim;
+  stream->buf = buf;
+  stream->size = size;
+}
+
+void nuts_getopts_stream_init_fd(nuts_getopts_stream* stream, int fd, char delim, char* buf, size_t size) {
+  nuts_getopts_stream_init(stream, read_fd, &stream->fd, delim, buf, size);
+  stream->fd = fd;
+}
+
+void nuts_getopts_stream_init_buffer(nuts_getopts_stream* stream, const char* data, size_t len, char delim) {
+  nuts_getopts_stream_init(stream, NULL, NULL, delim, (char*)data, len);
+  stream->tail = len;
+  stream->eof = 1;
+}
+
+int nuts_getopts_stream_error(const nuts_getopts_stream* stream) {
+  return stream->error;
+}
+
+/*
+ * Moves the unparsed data to the front of the buffer and appends data from
+ * the source. Returns 0 if new data is available, -1 otherwise.
+ */
+static int refill(nuts_getopts_stream* stream) {
+  long nread;
+
+  if (stream->eof)
+    return -1;
+
+  if (stream->head > 0) {
+    memmove(stream->buf, stream->buf + stream->head, stream->tail - stream->head);
+    stream->tail -= stream->head;
+    stream->head = 0;
+  }
+
+  // The whole buffer is filled. A token is terminated in place of its
+  // delimiter, the last token behind the data read before the end of the
+  // input, which left room for at least one byte.
+  if (stream->tail >= stream->size)
+    return -1;
+
+  if ((nread = stream->read(stream->ctx, stream->buf + stream->tail, stream->size - stream->tail)) <= 0) {
+    stream->eof = 1;
+    stream->error = (nread < 0) ? errno : 0;
+    return -1;
+  }
+
+  stream->tail += nread;
+
+  return 0;
+}
+
+/*
+ * Fetches the next token from the stream. Returns -1 if the stream is
+ * exhausted. If a token does not fit into the buffer, 1 is returned and token
+ * contains the part of it available in the buffer.
+ */
+static int next_token(nuts_getopts_stream* stream, struct token* token) {
+  const char* start;
+  const char* end;
+
+  for (;;) {
+    start = stream->buf + stream->head;
+    end = memchr(start, stream->delim, stream->tail - stream->head);
+
+    if (end != NULL) {
+      if (!stream->skip)
+        break;
+
+      // End of a token, which did not fit into the buffer.
+      stream->head = end - stream->buf + 1;
+      stream->skip = 0;
+      continue;
+    }
+
+    if (refill(stream) == 0)
+      continue;
+
+    // refill() may have moved the data to the front of the buffer.
+    start = stream->buf + stream->head;
+
+    if (stream->head == stream->tail)
+      return -1;
+
+    if (!stream->eof) {
+      // The buffer is full, the token is skipped. The part in the buffer is
+      // still reported, the buffer is re-filled with the next invocation.
+      int report = !stream->skip;
+
+      token->str = start;
+      token->len = stream->tail - stream->head;
+      token->eq = -1;
+
+      stream->head = stream->tail = 0;
+      stream->skip = 1;
+
+      if (report)
+        return 1;
+      continue;
+    }
+
+    if (stream->skip) {
+      stream->head = stream->tail;
+      return -1;
+    }
+
+    // The last token is not terminated by a delimiter.
+    end = stream->buf + stream->tail;
+    break;
+  }
+
+  token->str = start;
+  token->len = end - start;
+
+  stream->head = end - stream->buf + 1;
+  if (stream->head > stream->tail)
+    stream->head = stream->tail;
+
+  // Data read from the source is owned by the stream, the token can be
+  // terminated in place.
+  if (stream->read != NULL)
+    ((char*)start)[token->len] = '\0';
+
+  end = memchr(start, '=', token->len);
+  token->eq = (end != NULL) ? end - start : -1;
+
+  return 0;
+}
+
+static int parse_stream(nuts_getopts_stream* stream, const struct resolver* resolver, int flags, struct nuts_getopts_event* event) {
+  struct token token;
+  int again = 1;
+
+  memset(event, 0, sizeof(struct nuts_getopts_event));
+
+  while (again) {
+    switch (next_token(stream, &token)) {
+      case -1:
+        return -1;
+      case 1:
+        event->type = nuts_getopts_error_event;
+        event->u.err.type = nuts_getopts_argument_too_long;
+        event->u.err.option = token.str;
+        event->u.err.option_len = token.len;
+        return 0;
+    }
+
+    // Empty tokens (e.g. blank lines) are skipped.
+    if (token.len > 0)
+      again = nuts_getopts_on_token(&token, 0, resolver, flags, event);
+  }
+
+  return 0;
+}
+
+int nuts_getopts_stream_group(nuts_getopts_stream* stream, const struct nuts_getopts_option_group* groups, int flags, struct nuts_getopts_event* event) {
+  const struct resolver resolver = { .groups = groups };
+
+  return parse_stream(stream, &resolver, flags, event);
+}
+
+int nuts_getopts_stream_spec(nuts_getopts_stream* stream, const nuts_getopts_spec* spec, int flags, struct nuts_getopts_event* event) {
+  const struct resolver resolver = { .spec = spec };
+
+  return parse_stream(stream, &resolver, flags, event);
+}
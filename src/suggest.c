@@ -0,0 +1,251 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <string.h>
+
+#include "private.h"
+
+/*
+ * The BK-tree is a metric tree: each child of a node is labeled with the edit
+ * distance d of its name to the name of the node, and all names in the
+ * subtree of the child have the distance d to the node as well. Because of
+ * the triangle inequality, a search for names within the distance limit of a
+ * query, which has the distance d to a node, only needs to descend into the
+ * children labeled d - limit ... d + limit.
+ */
+
+// Size of the distance row kept on the stack, longer names use the heap.
+#define ROW_SIZE 128
+
+// Maximum number of suggestions returned by nuts_getopts_suggest().
+#define MAX_MATCHES 32
+
+static inline int min3(int a, int b, int c) {
+  int m = (a < b) ? a : b;
+  return (m < c) ? m : c;
+}
+
+static inline const char* name_of(const nuts_getopts_spec* spec, int ord) {
+  return spec->pool + spec->names[ord];
+}
+
+// Levenshtein distance between a and b, row has room for lb + 1 elements.
+static int distance(const char* a, int la, const char* b, int lb, int* row) {
+  int i, j;
+
+  for (j = 0; j <= lb; j++)
+    row[j] = j;
+
+  for (i = 1; i <= la; i++) {
+    int diag = row[0];
+
+    row[0] = i;
+
+    for (j = 1; j <= lb; j++) {
+      int up = row[j];
+
+      row[j] = min3(up + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1]));
+      diag = up;
+    }
+  }
+
+  return row[lb];
+}
+
+// The arena of the index is not thread-safe, queries with long names use the
+// heap.
+static int* alloc_row(const nuts_getopts_suggestions* suggestions, nuts_getopts_arena* arena, int* buf) {
+  if (suggestions->max_len < ROW_SIZE)
+    return buf;
+  else
+    return nuts_getopts_calloc(arena, (suggestions->max_len + 1) * sizeof(int));
+}
+
+static void free_row(nuts_getopts_arena* arena, int* row, int* buf) {
+  if (row != buf)
+    nuts_getopts_free(arena, row);
+}
+
+static void insert(nuts_getopts_suggestions* suggestions, int ord, int* row) {
+  const nuts_getopts_spec* spec = suggestions->spec;
+  struct bk_node* nodes = suggestions->nodes;
+  int node = 0;
+
+  for (;;) {
+    int other = nodes[node].ord;
+    int d = distance(name_of(spec, ord), spec->lens[ord], name_of(spec, other), spec->lens[other], row);
+    int child;
+
+    for (child = nodes[node].child; child != 0; child = nodes[child].sibling) {
+      if (nodes[child].dist == d)
+        break;
+    }
+
+    if (child == 0) {
+      struct bk_node* new_node = &nodes[child = suggestions->nnodes++];
+
+      new_node->ord = ord;
+      new_node->dist = d;
+      new_node->sibling = nodes[node].child;
+      nodes[node].child = child;
+      return;
+    }
+
+    node = child;
+  }
+}
+
+/*
+ * The best matches found so far, ordered by distance and ordinal.
+ */
+struct matches {
+  const struct nuts_getopts_option** options;
+  int* dists;
+  int* ords;
+  int size;
+  int count;
+
+  /* Distance limit of the search, shrinks as soon as size matches are found. */
+  int limit;
+};
+
+static void add_match(struct matches* m, const nuts_getopts_spec* spec, int ord, int d) {
+  int i;
+
+  if (m->count == m->size && (d > m->dists[m->size - 1] || (d == m->dists[m->size - 1] && ord > m->ords[m->size - 1])))
+    return;
+
+  if (m->count < m->size)
+    m->count++;
+
+  // Insertion sort, the worst match drops out of a full list.
+  for (i = m->count - 1; i > 0 && (m->dists[i - 1] > d || (m->dists[i - 1] == d && m->ords[i - 1] > ord)); i--) {
+    m->options[i] = m->options[i - 1];
+    m->dists[i] = m->dists[i - 1];
+    m->ords[i] = m->ords[i - 1];
+  }
+
+  m->options[i] = spec->options[ord];
+  m->dists[i] = d;
+  m->ords[i] = ord;
+
+  if (m->count == m->size && m->dists[m->size - 1] < m->limit)
+    m->limit = m->dists[m->size - 1];
+}
+
+static void search(const nuts_getopts_suggestions* suggestions, int node, const char* name, int len, int* row, struct matches* m) {
+  const nuts_getopts_spec* spec = suggestions->spec;
+  const struct bk_node* nodes = suggestions->nodes;
+  int ord = nodes[node].ord;
+  int d = distance(name, len, name_of(spec, ord), spec->lens[ord], row);
+  int child;
+
+  if (d <= m->limit)
+    add_match(m, spec, ord, d);
+
+  for (child = nodes[node].child; child != 0; child = nodes[child].sibling) {
+    if (nodes[child].dist >= d - m->limit && nodes[child].dist <= d + m->limit)
+      search(suggestions, child, name, len, row, m);
+  }
+}
+
+nuts_getopts_suggestions* nuts_getopts_suggestions_compile(const nuts_getopts_spec* spec) {
+  return nuts_getopts_suggestions_compile_arena(spec, NULL);
+}
+
+nuts_getopts_suggestions* nuts_getopts_suggestions_compile_arena(const nuts_getopts_spec* spec, nuts_getopts_arena* arena) {
+  nuts_getopts_suggestions* suggestions;
+  int buf[ROW_SIZE];
+  int* row;
+  int ord;
+
+  if ((suggestions = nuts_getopts_calloc(arena, sizeof(nuts_getopts_suggestions))) == NULL)
+    return NULL;
+
+  suggestions->spec = spec;
+  suggestions->arena = arena;
+
+  for (ord = 1; ord <= spec->noptions; ord++) {
+    if (spec->lens[ord] > suggestions->max_len)
+      suggestions->max_len = spec->lens[ord];
+  }
+
+  if ((suggestions->nodes = nuts_getopts_calloc(arena, (spec->noptions + 1) * sizeof(struct bk_node))) == NULL ||
+      (row = alloc_row(suggestions, arena, buf)) == NULL) {
+    nuts_getopts_suggestions_free(suggestions);
+    return NULL;
+  }
+
+  for (ord = 1; ord <= spec->noptions; ord++) {
+    if (spec->lens[ord] < 0)
+      continue;
+
+    if (suggestions->nnodes == 0)
+      suggestions->nodes[suggestions->nnodes++].ord = ord;
+    else
+      insert(suggestions, ord, row);
+  }
+
+  free_row(arena, row, buf);
+
+  return suggestions;
+}
+
+void nuts_getopts_suggestions_free(nuts_getopts_suggestions* suggestions) {
+  if (suggestions != NULL) {
+    nuts_getopts_free(suggestions->arena, suggestions->nodes);
+    nuts_getopts_free(suggestions->arena, suggestions);
+  }
+}
+
+int nuts_getopts_suggest(const nuts_getopts_suggestions* suggestions, const char* name, int name_len, int max_distance, const struct nuts_getopts_option** options, int size) {
+  int dists[MAX_MATCHES], ords[MAX_MATCHES];
+  struct matches m = { .options = options, .dists = dists, .ords = ords, .limit = max_distance };
+  const char* eq;
+  int buf[ROW_SIZE];
+  int* row;
+
+  if (suggestions->nnodes == 0 || size <= 0 || max_distance < 0)
+    return 0;
+
+  // A short option (-x) has no long name to be similar to.
+  if (name_len > 0 && name[0] == '-' && (name_len == 1 || name[1] != '-'))
+    return 0;
+
+  m.size = (size < MAX_MATCHES) ? size : MAX_MATCHES;
+
+  // Accept the option as reported by an error event: "--name=value".
+  for (; name_len > 0 && *name == '-'; name++, name_len--);
+
+  if ((eq = memchr(name, '=', name_len)) != NULL)
+    name_len = eq - name;
+
+  if ((row = alloc_row(suggestions, NULL, buf)) == NULL)
+    return -1;
+
+  search(suggestions, 0, name, name_len, row, &m);
+  free_row(NULL, row, buf);
+
+  return m.count;
+}
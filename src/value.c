@@ -0,0 +1,406 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+#include <float.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "private.h"
+
+/*
+ * Locale independent parsers for typed option values. All parsers work on
+ * length-delimited strings, the value is not necessarily NUL-terminated.
+ */
+
+// Powers of ten exactly representable by a double.
+static const double pow10_table[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline int is_digit(char c) {
+  return (unsigned char)(c - '0') < 10;
+}
+
+static inline char to_lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static int equals(const char* str, int len, const char* word) {
+  int i;
+
+  for (i = 0; i < len; i++) {
+    if (word[i] == '\0' || to_lower(str[i]) != word[i])
+      return 0;
+  }
+
+  return word[len] == '\0';
+}
+
+/*
+ * Parses an unsigned decimal or (with 0x prefix) hexadecimal number at the
+ * beginning of str. Returns the number of consumed characters, 0 if there is
+ * no number and -1 on overflow.
+ */
+static int parse_digits(const char* str, int len, uint64_t* out) {
+  uint64_t n = 0;
+  int i = 0;
+
+  if (len > 2 && str[0] == '0' && to_lower(str[1]) == 'x') {
+    for (i = 2; i < len; i++) {
+      char c = to_lower(str[i]);
+      unsigned int digit;
+
+      if (is_digit(c))
+        digit = c - '0';
+      else if (c >= 'a' && c <= 'f')
+        digit = c - 'a' + 10;
+      else
+        break;
+
+      if (n > (UINT64_MAX >> 4))
+        return -1;
+
+      n = (n << 4) | digit;
+    }
+
+    if (i == 2)
+      return 0;
+  } else {
+    for (; i < len && is_digit(str[i]); i++) {
+      unsigned int digit = str[i] - '0';
+
+      if (n > (UINT64_MAX - digit) / 10)
+        return -1;
+
+      n = n * 10 + digit;
+    }
+  }
+
+  *out = n;
+
+  return i;
+}
+
+static int parse_uint64(const char* str, int len, uint64_t* out) {
+  int n;
+
+  if (len > 0 && str[0] == '+') {
+    str++;
+    len--;
+  }
+
+  if ((n = parse_digits(str, len, out)) < 0)
+    return nuts_getopts_value_out_of_range;
+
+  return (n > 0 && n == len) ? 0 : nuts_getopts_invalid_value;
+}
+
+static int parse_int64(const char* str, int len, int64_t* out) {
+  int negative = (len > 0 && str[0] == '-');
+  uint64_t n;
+  int n_len;
+
+  if (len > 0 && (str[0] == '-' || str[0] == '+')) {
+    str++;
+    len--;
+  }
+
+  if ((n_len = parse_digits(str, len, &n)) < 0)
+    return nuts_getopts_value_out_of_range;
+  if (n_len == 0 || n_len != len)
+    return nuts_getopts_invalid_value;
+
+  if (negative) {
+    if (n > (uint64_t)INT64_MAX + 1)
+      return nuts_getopts_value_out_of_range;
+    *out = (n == (uint64_t)INT64_MAX + 1) ? INT64_MIN : -(int64_t)n;
+  } else {
+    if (n > INT64_MAX)
+      return nuts_getopts_value_out_of_range;
+    *out = n;
+  }
+
+  return 0;
+}
+
+// Significant digits passed to strtod(). A decimal number halfway between two
+// doubles has at most 767 of them, the digits behind are only noted.
+#define MAX_DIGITS 800
+
+/*
+ * Converts the digits of str (integer and fraction part, validated by
+ * parse_double()) multiplied by 10^exp10 with strtod(), which rounds
+ * correctly. The decimal point is left out and the exponent is passed
+ * explicitly, so the result does not depend on the locale.
+ */
+static double convert_digits(const char* str, int len, int exp10) {
+  char buf[MAX_DIGITS + 16];
+  int n = 0, frac = 0, sticky = 0, i;
+
+  for (i = 0; i < len && (is_digit(str[i]) || str[i] == '.'); i++) {
+    if (str[i] == '.') {
+      frac = 1;
+    } else if (n == 0 && str[i] == '0') {
+      exp10 -= frac;
+    } else if (n < MAX_DIGITS) {
+      buf[n++] = str[i];
+      exp10 -= frac;
+    } else {
+      exp10 += !frac;
+      sticky |= (str[i] != '0');
+    }
+  }
+
+  if (n == 0)
+    return 0;
+
+  // A non-zero digit behind the kept digits decides ties.
+  if (sticky) {
+    buf[n++] = '1';
+    exp10--;
+  }
+
+  snprintf(buf + n, sizeof(buf) - n, "e%d", exp10);
+
+  return strtod(buf, NULL);
+}
+
+static int parse_double(const char* str, int len, double* out) {
+  int negative = 0, ndigits = 0, exp10 = 0, e = 0, i = 0, start;
+  uint64_t mantissa = 0;
+  double d;
+
+  if (i < len && (str[i] == '-' || str[i] == '+'))
+    negative = (str[i++] == '-');
+
+  start = i;
+
+  // Up to 19 significant digits are kept in the mantissa, further digits
+  // only affect the exponent.
+  for (; i < len && is_digit(str[i]); i++, ndigits++) {
+    if (mantissa < 1000000000000000000ull)
+      mantissa = mantissa * 10 + (str[i] - '0');
+    else
+      exp10++;
+  }
+
+  if (i < len && str[i] == '.') {
+    for (i++; i < len && is_digit(str[i]); i++, ndigits++) {
+      if (mantissa < 1000000000000000000ull) {
+        mantissa = mantissa * 10 + (str[i] - '0');
+        exp10--;
+      }
+    }
+  }
+
+  if (ndigits == 0)
+    return nuts_getopts_invalid_value;
+
+  // The exponent is decimal only, unlike integer values.
+  if (i < len && to_lower(str[i]) == 'e') {
+    int e_negative = 0, e_start;
+
+    if (++i < len && (str[i] == '-' || str[i] == '+'))
+      e_negative = (str[i++] == '-');
+
+    for (e_start = i; i < len && is_digit(str[i]); i++) {
+      if (e <= 100000)
+        e = e * 10 + (str[i] - '0');
+    }
+
+    if (i == e_start || i != len)
+      return nuts_getopts_invalid_value;
+    if (e > 100000)
+      return nuts_getopts_value_out_of_range;
+
+    if (e_negative)
+      e = -e;
+  }
+
+  if (i != len)
+    return nuts_getopts_invalid_value;
+
+  exp10 += e;
+
+  // A mantissa below 2^53 and the powers of ten up to 22 are exact, a single
+  // multiplication or division rounds correctly. Otherwise strtod() does.
+  if (mantissa < (1ull << 53) && exp10 >= -22 && exp10 <= 22)
+    d = (exp10 >= 0) ? mantissa * pow10_table[exp10] : mantissa / pow10_table[-exp10];
+  else
+    d = convert_digits(str + start, len - start, e);
+
+  if (d > DBL_MAX)
+    return nuts_getopts_value_out_of_range;
+
+  *out = negative ? -d : d;
+
+  return 0;
+}
+
+static int parse_bool(const char* str, int len, int* out) {
+  if (equals(str, len, "1") || equals(str, len, "true") || equals(str, len, "yes") || equals(str, len, "on"))
+    *out = 1;
+  else if (equals(str, len, "0") || equals(str, len, "false") || equals(str, len, "no") || equals(str, len, "off"))
+    *out = 0;
+  else
+    return nuts_getopts_invalid_value;
+
+  return 0;
+}
+
+/*
+ * A size with an optional binary suffix: 4096, 4K, 4KB, 4KiB, 2G, ...
+ */
+static int parse_size(const char* str, int len, uint64_t* out) {
+  static const char suffixes[] = "kmgtpe";
+  uint64_t n;
+  int n_len, shift = 0;
+
+  if ((n_len = parse_digits(str, len, &n)) < 0)
+    return nuts_getopts_value_out_of_range;
+  if (n_len == 0)
+    return nuts_getopts_invalid_value;
+
+  str += n_len;
+  len -= n_len;
+
+  if (len > 0) {
+    char c = to_lower(str[0]);
+    int i;
+
+    for (i = 0; suffixes[i] != '\0'; i++) {
+      if (suffixes[i] == c) {
+        shift = 10 * (i + 1);
+        str++;
+        len--;
+        break;
+      }
+    }
+
+    if (!equals(str, len, "") && !equals(str, len, "b") && !(shift > 0 && equals(str, len, "ib")))
+      return nuts_getopts_invalid_value;
+  }
+
+  if (shift > 0 && n > (UINT64_MAX >> shift))
+    return nuts_getopts_value_out_of_range;
+
+  *out = n << shift;
+
+  return 0;
+}
+
+/*
+ * A duration converted into nanoseconds. The value is a sequence of numbers
+ * with a unit (ns, us, ms, s, m, h, d), e.g. 500ms or 1h30m. A single number
+ * without unit is taken as seconds.
+ */
+static int parse_duration(const char* str, int len, uint64_t* out) {
+  static const struct {
+    const char* name;
+    uint64_t ns;
+  } units[] = {
+    { "ns", 1ull },
+    { "us", 1000ull },
+    { "ms", 1000000ull },
+    { "s",  1000000000ull },
+    { "m",  60000000000ull },
+    { "h",  3600000000000ull },
+    { "d",  86400000000000ull },
+  };
+  uint64_t total = 0;
+  int i = 0;
+
+  if (len == 0)
+    return nuts_getopts_invalid_value;
+
+  while (i < len) {
+    uint64_t n, ns = 0;
+    int n_len, u_len, u;
+
+    if ((n_len = parse_digits(str + i, len - i, &n)) < 0)
+      return nuts_getopts_value_out_of_range;
+    if (n_len == 0)
+      return nuts_getopts_invalid_value;
+
+    i += n_len;
+
+    for (u_len = 0; i + u_len < len && !is_digit(str[i + u_len]); u_len++);
+
+    if (u_len == 0) {
+      // Only a single plain number is accepted.
+      if (n_len != len)
+        return nuts_getopts_invalid_value;
+      ns = units[3].ns;
+    }
+
+    for (u = 0; u_len > 0 && u < (int)(sizeof(units) / sizeof(units[0])); u++) {
+      if (equals(str + i, u_len, units[u].name)) {
+        ns = units[u].ns;
+        break;
+      }
+    }
+
+    if (ns == 0)
+      return nuts_getopts_invalid_value;
+    if (n > (UINT64_MAX - total) / ns)
+      return nuts_getopts_value_out_of_range;
+
+    total += n * ns;
+    i += u_len;
+  }
+
+  *out = total;
+
+  return 0;
+}
+
+int nuts_getopts_convert(nuts_getopts_value_type type, const char* str, int len, union nuts_getopts_typed* out) {
+  // An option without argument can only be a boolean flag.
+  if (str == NULL) {
+    if (type == nuts_getopts_bool_value)
+      out->b = 1;
+    return 0;
+  }
+
+  switch (type) {
+    case nuts_getopts_string_value:
+      return 0;
+    case nuts_getopts_int64_value:
+      return parse_int64(str, len, &out->i64);
+    case nuts_getopts_uint64_value:
+      return parse_uint64(str, len, &out->u64);
+    case nuts_getopts_double_value:
+      return parse_double(str, len, &out->f64);
+    case nuts_getopts_bool_value:
+      return parse_bool(str, len, &out->b);
+    case nuts_getopts_size_value:
+      return parse_size(str, len, &out->u64);
+    case nuts_getopts_duration_value:
+      return parse_duration(str, len, &out->u64);
+  }
+
+  return nuts_getopts_invalid_value;
+}
@@ -0,0 +1,502 @@
+/******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2020 Robin Doer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * Generates the option table of a tool from a declarative spec.
+ *
+ * Usage: nuts-getopts-gen <name> <spec> <source> <header>
+ *
+ * Each line of the spec defines an option:
+ *
+ *   <short> <long> <argument> [<type>]
+ *
+ * <short> is a single character, <long> the long name, `-` stands for "no
+ * name". <argument> is `none`, `required` or `multi`, the optional <type> one of
+ * `string`, `int64`, `uint64`, `double`, `bool`, `size` or `duration`. Empty
+ * lines and lines starting with `#` are skipped.
+ *
+ * The source file defines the table <name>_options and a lookup
+ * <name>_lookup for nuts_getopts_lookup_parse(). Short names are dispatched
+ * by a switch statement, long names are found by a minimal perfect hash, so
+ * the generated parser needs no setup at runtime.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 1024
+#define MAX_DISPLACEMENT 1000000
+
+// Number of long names per bucket of the first hash level.
+#define BUCKET_SIZE 4
+
+struct option {
+  int sname;
+  char* lname;
+  const char* arg;
+  const char* type;
+};
+
+struct spec {
+  struct option* options;
+  int count;
+};
+
+static const char* arg_names[][2] = {
+  { "none",     "nuts_getopts_no_argument" },
+  { "required", "nuts_getopts_required_argument" },
+  { "multi",    "nuts_getopts_multi_argument" },
+  { NULL }
+};
+
+static const char* type_names[][2] = {
+  { "string",   "nuts_getopts_string_value" },
+  { "int64",    "nuts_getopts_int64_value" },
+  { "uint64",   "nuts_getopts_uint64_value" },
+  { "double",   "nuts_getopts_double_value" },
+  { "bool",     "nuts_getopts_bool_value" },
+  { "size",     "nuts_getopts_size_value" },
+  { "duration", "nuts_getopts_duration_value" },
+  { NULL }
+};
+
+// Must match the hash function emitted into the generated source.
+static uint32_t hash(const char* str, int len, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    h ^= (unsigned char)str[i];
+    h *= 16777619u;
+  }
+
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+
+  return h;
+}
+
+static const char* hash_source =
+  "static uint32_t hash(const char* str, int len, uint32_t seed) {\n"
+  "  uint32_t h = 2166136261u ^ seed;\n"
+  "  int i;\n"
+  "\n"
+  "  for (i = 0; i < len; i++) {\n"
+  "    h ^= (unsigned char)str[i];\n"
+  "    h *= 16777619u;\n"
+  "  }\n"
+  "\n"
+  "  h ^= h >> 16;\n"
+  "  h *= 0x85ebca6bu;\n"
+  "  h ^= h >> 13;\n"
+  "  h *= 0xc2b2ae35u;\n"
+  "  h ^= h >> 16;\n"
+  "\n"
+  "  return h;\n"
+  "}\n";
+
+static const char* lookup_name(const char* names[][2], const char* name) {
+  int i;
+
+  for (i = 0; names[i][0] != NULL; i++) {
+    if (strcmp(names[i][0], name) == 0)
+      return names[i][1];
+  }
+
+  return NULL;
+}
+
+static int fail(const char* path, int line, const char* msg) {
+  fprintf(stderr, "%s:%d: %s\n", path, line, msg);
+  return -1;
+}
+
+static int parse_line(const char* path, int line, char* buf, struct option* option) {
+  char* fields[4] = { NULL };
+  char* tok;
+  int n = 0;
+
+  for (tok = strtok(buf, " \t\r\n"); tok != NULL; tok = strtok(NULL, " \t\r\n")) {
+    if (n == 4)
+      return fail(path, line, "too many fields");
+    fields[n++] = tok;
+  }
+
+  if (n < 3)
+    return fail(path, line, "expected <short> <long> <argument> [<type>]");
+
+  if (strlen(fields[0]) != 1 || isspace((unsigned char)fields[0][0]))
+    return fail(path, line, "short name must be a single character");
+
+  option->sname = (strcmp(fields[0], "-") == 0) ? 0 : fields[0][0];
+  option->lname = (strcmp(fields[1], "-") == 0) ? NULL : strdup(fields[1]);
+
+  if (option->sname == 0 && option->lname == NULL)
+    return fail(path, line, "option without a name");
+
+  if ((option->arg = lookup_name(arg_names, fields[2])) == NULL)
+    return fail(path, line, "argument must be none, required or multi");
+
+  if ((option->type = lookup_name(type_names, (n == 4) ? fields[3] : "string")) == NULL)
+    return fail(path, line, "unknown type");
+
+  return 0;
+}
+
+static int check_duplicates(const char* path, const struct spec* spec) {
+  int i, j;
+
+  for (i = 0; i < spec->count; i++) {
+    const struct option* a = &spec->options[i];
+
+    for (j = i + 1; j < spec->count; j++) {
+      const struct option* b = &spec->options[j];
+
+      if (a->sname != 0 && a->sname == b->sname)
+        return fail(path, 0, "duplicate short name");
+      if (a->lname != NULL && b->lname != NULL && strcmp(a->lname, b->lname) == 0)
+        return fail(path, 0, "duplicate long name");
+    }
+  }
+
+  return 0;
+}
+
+static int read_spec(const char* path, struct spec* spec) {
+  FILE* f = fopen(path, "r");
+  struct option* options;
+  char buf[MAX_LINE];
+  int line = 0;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+
+  while (fgets(buf, sizeof(buf), f) != NULL) {
+    char* p = buf;
+
+    line++;
+
+    while (isspace((unsigned char)*p))
+      p++;
+
+    if (*p == '\0' || *p == '#')
+      continue;
+
+    if ((options = realloc(spec->options, (spec->count + 1) * sizeof(struct option))) == NULL) {
+      perror(path);
+      fclose(f);
+      return -1;
+    }
+
+    spec->options = options;
+
+    if (parse_line(path, line, p, &spec->options[spec->count]) != 0) {
+      fclose(f);
+      return -1;
+    }
+
+    spec->count++;
+  }
+
+  fclose(f);
+
+  return check_duplicates(path, spec);
+}
+
+/*
+ * Builds a minimal perfect hash (hash and displace) over the n long names
+ * keys. A name is assigned to the bucket hash(name, 0) % nbuckets. All names
+ * of a bucket are placed at the slot hash(name, displacement) % n, where the
+ * displacement of the bucket is chosen so that no slot is used twice. Large
+ * buckets are placed first, while most slots are still free.
+ */
+static int build_hash(char** keys, int n, int nbuckets, uint32_t* displacements, int* slots) {
+  int* bucket_of = calloc(n, sizeof(int));
+  int* bucket_size = calloc(nbuckets, sizeof(int));
+  int* order = calloc(nbuckets, sizeof(int));
+  int* placed = calloc(n, sizeof(int));
+  int b, i, j, result = 0;
+
+  if (bucket_of == NULL || bucket_size == NULL || order == NULL || placed == NULL) {
+    free(bucket_of);
+    free(bucket_size);
+    free(order);
+    free(placed);
+    return -1;
+  }
+
+  for (i = 0; i < n; i++) {
+    bucket_of[i] = hash(keys[i], strlen(keys[i]), 0) % nbuckets;
+    bucket_size[bucket_of[i]]++;
+  }
+
+  for (i = 0; i < nbuckets; i++)
+    order[i] = i;
+
+  // Insertion sort by decreasing bucket size.
+  for (i = 1; i < nbuckets; i++) {
+    for (j = i; j > 0 && bucket_size[order[j - 1]] < bucket_size[order[j]]; j--) {
+      int tmp = order[j];
+      order[j] = order[j - 1];
+      order[j - 1] = tmp;
+    }
+  }
+
+  for (i = 0; i < n; i++)
+    slots[i] = -1;
+
+  for (b = 0; b < nbuckets && bucket_size[order[b]] > 0; b++) {
+    int bucket = order[b];
+    uint32_t d;
+
+    for (d = 1; d < MAX_DISPLACEMENT; d++) {
+      int nplaced = 0, ok = 1;
+
+      for (i = 0; i < n && ok; i++) {
+        if (bucket_of[i] == bucket) {
+          int slot = hash(keys[i], strlen(keys[i]), d) % n;
+
+          if (slots[slot] >= 0) {
+            ok = 0;
+          } else {
+            slots[slot] = i;
+            placed[nplaced++] = slot;
+          }
+        }
+      }
+
+      if (ok)
+        break;
+
+      // Undo the partial placement and try the next displacement.
+      for (i = 0; i < nplaced; i++)
+        slots[placed[i]] = -1;
+    }
+
+    if (d == MAX_DISPLACEMENT) {
+      result = -1;
+      break;
+    }
+
+    displacements[bucket] = d;
+  }
+
+  free(bucket_of);
+  free(bucket_size);
+  free(order);
+  free(placed);
+
+  return result;
+}
+
+static void write_string(FILE* f, const char* str) {
+  fputc('"', f);
+
+  for (; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\')
+      fputc('\\', f);
+    fputc(*str, f);
+  }
+
+  fputc('"', f);
+}
+
+static void write_char(FILE* f, int c) {
+  if (c == 0)
+    fprintf(f, "0");
+  else if (c == '\'' || c == '\\')
+    fprintf(f, "'\\%c'", c);
+  else
+    fprintf(f, "'%c'", c);
+}
+
+static int write_source(const char* path, const char* name, const char* spec_path, const struct spec* spec) {
+  FILE* f = fopen(path, "w");
+  char** keys = calloc(spec->count + 1, sizeof(char*));
+  int* key_option = calloc(spec->count + 1, sizeof(int));
+  int nkeys = 0, nbuckets, i;
+  uint32_t* displacements;
+  int* slots;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+
+  if (keys == NULL || key_option == NULL) {
+    perror(spec_path);
+    fclose(f);
+    return -1;
+  }
+
+  for (i = 0; i < spec->count; i++) {
+    if (spec->options[i].lname != NULL) {
+      keys[nkeys] = spec->options[i].lname;
+      key_option[nkeys++] = i;
+    }
+  }
+
+  nbuckets = (nkeys + BUCKET_SIZE - 1) / BUCKET_SIZE;
+  displacements = calloc(nbuckets + 1, sizeof(uint32_t));
+  slots = calloc(nkeys + 1, sizeof(int));
+
+  if (displacements == NULL || slots == NULL) {
+    perror(spec_path);
+    fclose(f);
+    return -1;
+  }
+
+  if (nkeys > 0 && build_hash(keys, nkeys, nbuckets, displacements, slots) != 0) {
+    fclose(f);
+    return fail(spec_path, 0, "cannot build a perfect hash");
+  }
+
+  fprintf(f, "/* Generated by nuts-getopts-gen from %s, do not edit. */\n\n", spec_path);
+  fprintf(f, "#include <stdint.h>\n#include <string.h>\n\n#include \"%s.h\"\n\n", name);
+
+  fprintf(f, "const struct nuts_getopts_option %s_options[] = {\n", name);
+  for (i = 0; i < spec->count; i++) {
+    const struct option* option = &spec->options[i];
+
+    fprintf(f, "  { ");
+    write_char(f, option->sname);
+    fprintf(f, ", ");
+    if (option->lname != NULL)
+      write_string(f, option->lname);
+    else
+      fprintf(f, "NULL");
+    fprintf(f, ", %s, %s },\n", option->arg, option->type);
+  }
+  fprintf(f, "  { 0 }\n};\n\n");
+
+  fprintf(f, "static const struct nuts_getopts_option* find_short(char sname) {\n");
+  fprintf(f, "  switch (sname) {\n");
+  for (i = 0; i < spec->count; i++) {
+    if (spec->options[i].sname != 0) {
+      fprintf(f, "    case ");
+      write_char(f, spec->options[i].sname);
+      fprintf(f, ": return &%s_options[%d];\n", name, i);
+    }
+  }
+  fprintf(f, "    default: return NULL;\n  }\n}\n\n");
+
+  if (nkeys > 0) {
+    fprintf(f, "#define NBUCKETS %d\n#define NSLOTS %d\n\n", nbuckets, nkeys);
+
+    fprintf(f, "static const uint32_t displacements[NBUCKETS] = {");
+    for (i = 0; i < nbuckets; i++)
+      fprintf(f, "%s%s%u", (i > 0) ? "," : "", (i % 12 == 0) ? "\n  " : " ", displacements[i]);
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f, "// Index into %s_options and length of the long name by slot.\n", name);
+    fprintf(f, "static const struct { int option; int len; } slots[NSLOTS] = {");
+    for (i = 0; i < nkeys; i++)
+      fprintf(f, "%s%s{ %d, %d }", (i > 0) ? "," : "", (i % 6 == 0) ? "\n  " : " ",
+        key_option[slots[i]], (int)strlen(keys[slots[i]]));
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f, "%s\n", hash_source);
+
+    fprintf(f, "static const struct nuts_getopts_option* find_long(const char* lname, int len) {\n");
+    fprintf(f, "  uint32_t d = displacements[hash(lname, len, 0) %% NBUCKETS];\n");
+    fprintf(f, "  uint32_t slot = hash(lname, len, d) %% NSLOTS;\n");
+    fprintf(f, "  const struct nuts_getopts_option* option = &%s_options[slots[slot].option];\n\n", name);
+    fprintf(f, "  return (slots[slot].len == len && memcmp(option->lname, lname, len) == 0) ? option : NULL;\n");
+    fprintf(f, "}\n\n");
+  } else {
+    fprintf(f, "static const struct nuts_getopts_option* find_long(const char* lname, int len) {\n");
+    fprintf(f, "  return NULL;\n}\n\n");
+  }
+
+  fprintf(f, "const struct nuts_getopts_lookup %s_lookup = { find_short, find_long };\n", name);
+
+  free(keys);
+  free(key_option);
+  free(displacements);
+  free(slots);
+
+  return fclose(f);
+}
+
+static int write_header(const char* path, const char* name, const char* spec_path) {
+  FILE* f = fopen(path, "w");
+  char guard[MAX_LINE];
+  int i;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+
+  for (i = 0; name[i] != '\0' && i < MAX_LINE - 1; i++)
+    guard[i] = toupper((unsigned char)name[i]);
+  guard[i] = '\0';
+
+  fprintf(f, "/* Generated by nuts-getopts-gen from %s, do not edit. */\n\n", spec_path);
+  fprintf(f, "#ifndef %s_H\n#define %s_H\n\n", guard, guard);
+  fprintf(f, "#include <nuts-getopts.h>\n\n");
+  fprintf(f, "extern const struct nuts_getopts_option %s_options[];\n", name);
+  fprintf(f, "extern const struct nuts_getopts_lookup %s_lookup;\n\n", name);
+  fprintf(f, "#endif\n");
+
+  return fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+  struct spec spec = { NULL, 0 };
+  const char* p;
+
+  if (argc != 5) {
+    fprintf(stderr, "usage: %s <name> <spec> <source> <header>\n", argv[0]);
+    return 1;
+  }
+
+  for (p = argv[1]; *p != '\0'; p++) {
+    if (!isalnum((unsigned char)*p) && *p != '_') {
+      fprintf(stderr, "%s: invalid name %s\n", argv[0], argv[1]);
+      return 1;
+    }
+  }
+
+  if (read_spec(argv[2], &spec) != 0)
+    return 1;
+
+  if (write_source(argv[3], argv[1], argv[2], &spec) != 0 || write_header(argv[4], argv[1], argv[2]) != 0) {
+    remove(argv[3]);
+    remove(argv[4]);
+    return 1;
+  }
+
+  return 0;
+}